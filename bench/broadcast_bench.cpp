@@ -0,0 +1,189 @@
+// ================================
+// WEBSOCKET BROADCAST BENCHMARK
+// ================================
+
+// Host benchmark for one WebSocket broadcast to 8 clients. It models how
+// ESPAsyncWebServer owns queued frames, because the library itself does not
+// build off the device:
+// - per-client copy: client->text(String) allocates a message that copies
+//   the payload, once per client (the old broadcast path)
+// - shared buffer: makeBuffer() copies the payload once into a reference
+//   counted buffer, each client queues a message pointing at it, and
+//   _cleanBuffers() frees it after the last send (the current path)
+// Both paths allocate the per-client message object and copy the bytes
+// into a send buffer when the frame is sent, as the TCP write would.
+//
+// Build and run:
+//   g++ -std=gnu++11 -O2 -o /tmp/broadcast_bench bench/broadcast_bench.cpp
+//   /tmp/broadcast_bench
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+
+static const int CLIENT_COUNT = 8;
+static const long ROUNDS = 200000L;
+static const size_t PAYLOAD_SIZES[] = { 256, 1024, 4096 };
+
+struct HeapStats {
+    unsigned long allocations;
+    unsigned long bytes;
+};
+
+static HeapStats heapStats = { 0, 0 };
+
+static void* countedAlloc(size_t size) {
+    heapStats.allocations++;
+    heapStats.bytes += size;
+    return malloc(size);
+}
+
+// ================================
+// FRAME MODEL
+// ================================
+
+struct SharedBuffer {
+    uint8_t* data;
+    size_t length;
+    int count;      // Queued messages still referring to it
+    bool locked;
+};
+
+struct Message {
+    const uint8_t* data;
+    size_t length;
+    uint8_t* owned;         // Per-client copy, freed with the message
+    SharedBuffer* shared;   // Shared buffer, released with the message
+};
+
+struct Client {
+    std::list<Message*> queue;
+    uint8_t sendBuffer[4096 + 16];
+    uint32_t checksum;
+};
+
+static Client clients[CLIENT_COUNT];
+static std::list<SharedBuffer*> buffers;
+
+static Message* newMessage() {
+    return new (countedAlloc(sizeof(Message))) Message();
+}
+
+static void sendQueued(Client& client) {
+    while (!client.queue.empty()) {
+        Message* message = client.queue.front();
+        client.queue.pop_front();
+
+        memcpy(client.sendBuffer, message->data, message->length);
+        client.checksum += client.sendBuffer[message->length - 1];
+
+        if (message->owned) {
+            free(message->owned);
+        }
+
+        if (message->shared) {
+            message->shared->count--;
+        }
+
+        free(message);
+    }
+}
+
+static void cleanBuffers() {
+    for (std::list<SharedBuffer*>::iterator it = buffers.begin(); it != buffers.end();) {
+        SharedBuffer* buffer = *it;
+
+        if (buffer->count == 0 && !buffer->locked) {
+            free(buffer->data);
+            free(buffer);
+            it = buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// ================================
+// BROADCAST PATHS
+// ================================
+
+static void broadcastCopy(const uint8_t* payload, size_t length) {
+    for (int i = 0; i < CLIENT_COUNT; i++) {
+        Message* message = newMessage();
+        message->owned = (uint8_t*)countedAlloc(length);
+        memcpy(message->owned, payload, length);
+        message->data = message->owned;
+        message->length = length;
+        clients[i].queue.push_back(message);
+    }
+}
+
+static void broadcastShared(const uint8_t* payload, size_t length) {
+    SharedBuffer* buffer = (SharedBuffer*)countedAlloc(sizeof(SharedBuffer));
+    buffer->data = (uint8_t*)countedAlloc(length);
+    buffer->length = length;
+    buffer->count = 0;
+    buffer->locked = true;
+    memcpy(buffer->data, payload, length);
+    buffers.push_back(buffer);
+
+    for (int i = 0; i < CLIENT_COUNT; i++) {
+        Message* message = newMessage();
+        message->data = buffer->data;
+        message->length = length;
+        message->shared = buffer;
+        buffer->count++;
+        clients[i].queue.push_back(message);
+    }
+
+    buffer->locked = false;
+}
+
+template <typename Broadcast>
+static void timeBroadcast(const char* name, Broadcast broadcast, const uint8_t* payload, size_t length) {
+    HeapStats before = heapStats;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long round = 0; round < ROUNDS; round++) {
+        broadcast(payload, length);
+
+        for (int i = 0; i < CLIENT_COUNT; i++) {
+            sendQueued(clients[i]);
+        }
+
+        cleanBuffers();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("  %-16s %7.0f ns/broadcast  %5.1f allocations  %7.0f bytes allocated\n",
+           name, seconds * 1e9 / ROUNDS,
+           double(heapStats.allocations - before.allocations) / ROUNDS,
+           double(heapStats.bytes - before.bytes) / ROUNDS);
+}
+
+int main() {
+    static uint8_t payload[4096];
+
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)('a' + i % 26);
+    }
+
+    for (size_t length : PAYLOAD_SIZES) {
+        printf("%u-byte frame to %d clients:\n", (unsigned)length, CLIENT_COUNT);
+        timeBroadcast("per-client copy", broadcastCopy, payload, length);
+        timeBroadcast("shared buffer", broadcastShared, payload, length);
+    }
+
+    uint32_t checksum = 0;
+    for (int i = 0; i < CLIENT_COUNT; i++) {
+        checksum += clients[i].checksum;
+    }
+
+    printf("(checksum %u, %u buffers left)\n", (unsigned)checksum, (unsigned)buffers.size());
+    return buffers.empty() ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+// ================================
+// CALLBACK DISPATCH BENCHMARK
+// ================================
+
+// Host microbenchmark for the SensorManager device-stat providers: the cost
+// of calling a set of capture-less callbacks through plain function pointers
+// (what the firmware stores now) versus through std::function (what it
+// stored before). Each round calls eight providers, the same count as
+// getDeviceStatistics().
+//
+// Build and run:
+//   g++ -std=gnu++11 -O2 -o /tmp/dispatch_bench bench/dispatch_bench.cpp
+//   /tmp/dispatch_bench
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+typedef uint32_t (*CounterProvider)();
+
+static const int PROVIDER_COUNT = 8;
+static const long ROUNDS = 20000000L;
+
+static volatile uint32_t counters[PROVIDER_COUNT];
+
+// Distinct bodies so the compiler cannot fold the providers together
+static uint32_t provider0() { return counters[0]; }
+static uint32_t provider1() { return counters[1] + 1; }
+static uint32_t provider2() { return counters[2] + 2; }
+static uint32_t provider3() { return counters[3] + 3; }
+static uint32_t provider4() { return counters[4] + 4; }
+static uint32_t provider5() { return counters[5] + 5; }
+static uint32_t provider6() { return counters[6] + 6; }
+static uint32_t provider7() { return counters[7] + 7; }
+
+static CounterProvider const PROVIDERS[PROVIDER_COUNT] = {
+    provider0, provider1, provider2, provider3,
+    provider4, provider5, provider6, provider7
+};
+
+struct PointerStats {
+    CounterProvider providers[PROVIDER_COUNT];
+};
+
+struct FunctionStats {
+    std::function<uint32_t()> providers[PROVIDER_COUNT];
+};
+
+// Kept out of line so each round really loads the stored callbacks
+__attribute__((noinline)) static uint32_t collect(const PointerStats& stats) {
+    uint32_t sum = 0;
+    for (int i = 0; i < PROVIDER_COUNT; i++) {
+        if (stats.providers[i]) sum += stats.providers[i]();
+    }
+    return sum;
+}
+
+__attribute__((noinline)) static uint32_t collect(const FunctionStats& stats) {
+    uint32_t sum = 0;
+    for (int i = 0; i < PROVIDER_COUNT; i++) {
+        if (stats.providers[i]) sum += stats.providers[i]();
+    }
+    return sum;
+}
+
+template <typename Stats>
+static double nsPerCall(const Stats& stats, uint32_t& sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (long round = 0; round < ROUNDS; round++) {
+        sink += collect(stats);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    return ns / (double(ROUNDS) * PROVIDER_COUNT);
+}
+
+int main(int argc, char**) {
+    PointerStats pointerStats;
+    FunctionStats functionStats;
+
+    // Index by argc so the table is only known at run time
+    for (int i = 0; i < PROVIDER_COUNT; i++) {
+        CounterProvider provider = PROVIDERS[(i + argc - 1) % PROVIDER_COUNT];
+        pointerStats.providers[i] = provider;
+        functionStats.providers[i] = provider;
+    }
+
+    uint32_t sink = 0;
+
+    // Warm up both paths before timing
+    nsPerCall(pointerStats, sink);
+    nsPerCall(functionStats, sink);
+
+    double pointerNs = nsPerCall(pointerStats, sink);
+    double functionNs = nsPerCall(functionStats, sink);
+
+    printf("function pointer: %.2f ns/call\n", pointerNs);
+    printf("std::function:    %.2f ns/call\n", functionNs);
+    printf("ratio:            %.2fx\n", functionNs / pointerNs);
+    printf("(checksum %u)\n", (unsigned)sink);
+    return 0;
+}
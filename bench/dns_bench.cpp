@@ -0,0 +1,161 @@
+// ================================
+// CAPTIVE DNS BENCHMARK
+// ================================
+
+// Host benchmark for CaptiveDNS: first buildResponse() alone on a mix of
+// captive portal lookups, then the whole responder (its task on a thread)
+// answering a client over UDP loopback with a window of queries in flight.
+// Both report queries per second. The loopback figure is bounded by the
+// host's socket stack, not the ESP32's, so compare runs, not absolutes.
+//
+// Build and run (from the repository root):
+//   g++ -std=gnu++11 -O2 -pthread -Ibench/host -Isrc -o /tmp/dns_bench bench/dns_bench.cpp bench/host/arduino_shim.cpp src/captive_dns.cpp
+//   /tmp/dns_bench [port]
+
+#include "captive_dns.h"
+#include <lwip/sockets.h>
+#include <chrono>
+
+static const char* const NAMES[] = {
+    "connectivitycheck.gstatic.com",
+    "captive.apple.com",
+    "www.msftconnecttest.com",
+    "detectportal.firefox.com"
+};
+
+static const uint16_t TYPE_A = 1;
+static const uint16_t TYPE_AAAA = 28;
+
+static const int QUERY_KINDS = 8;           // Every name as A and AAAA
+static const long BUILD_ROUNDS = 20000000L;
+static const int WINDOW = 32;               // Loopback queries in flight
+static const int LOOPBACK_SECONDS = 3;
+
+struct Query {
+    uint8_t packet[DNS_MAX_PACKET_SIZE];
+    size_t length;
+};
+
+static size_t writeQuery(uint8_t* packet, uint16_t id, const char* name, uint16_t type) {
+    const uint8_t header[12] = { (uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0 };
+    memcpy(packet, header, sizeof(header));
+    size_t pos = sizeof(header);
+
+    // Labels: length byte, then the characters up to the next dot
+    while (*name) {
+        const char* dot = strchr(name, '.');
+        size_t label = dot ? (size_t)(dot - name) : strlen(name);
+        packet[pos++] = (uint8_t)label;
+        memcpy(packet + pos, name, label);
+        pos += label;
+        name += label + (dot ? 1 : 0);
+    }
+
+    const uint8_t tail[5] = { 0, (uint8_t)(type >> 8), (uint8_t)type, 0, 1 };
+    memcpy(packet + pos, tail, sizeof(tail));
+    return pos + sizeof(tail);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ================================
+// BUILD RESPONSE
+// ================================
+
+static void benchBuildResponse(const Query* queries) {
+    CaptiveDNS dns;
+    uint8_t packet[DNS_MAX_PACKET_SIZE + DNS_ANSWER_SIZE];
+    size_t total = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (long round = 0; round < BUILD_ROUNDS; round++) {
+        const Query& query = queries[round % QUERY_KINDS];
+        memcpy(packet, query.packet, query.length);
+        total += dns.buildResponse(packet, query.length, sizeof(packet));
+    }
+
+    double seconds = secondsSince(start);
+
+    printf("buildResponse: %.1f M queries/s (%.1f ns/query, %u answered, %u empty, %lu bytes)\n",
+           BUILD_ROUNDS / seconds / 1e6, seconds * 1e9 / BUILD_ROUNDS,
+           dns.getAnswerCount(), dns.getEmptyCount(), (unsigned long)total);
+}
+
+// ================================
+// UDP LOOPBACK
+// ================================
+
+static bool benchLoopback(const Query* queries, uint16_t port) {
+    CaptiveDNS dns;
+
+    if (!dns.begin(IPAddress(192, 168, 4, 1), port)) {
+        fprintf(stderr, "Could not start the responder on port %u\n", port);
+        return false;
+    }
+
+    int client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    struct sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connect(client, (struct sockaddr*)&server, sizeof(server));
+
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 200000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    unsigned long sent = 0;
+    unsigned long answered = 0;
+    unsigned long timeouts = 0;
+    uint8_t response[DNS_MAX_PACKET_SIZE + DNS_ANSWER_SIZE];
+
+    // Keep WINDOW queries outstanding; each reply releases the next query
+    for (int i = 0; i < WINDOW; i++) {
+        const Query& query = queries[sent++ % QUERY_KINDS];
+        send(client, query.packet, query.length, 0);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (secondsSince(start) < LOOPBACK_SECONDS) {
+        ssize_t length = recv(client, response, sizeof(response), 0);
+
+        if (length < 0) {
+            // Lost datagram: put another query in flight to refill the window
+            timeouts++;
+        } else {
+            answered++;
+        }
+
+        const Query& query = queries[sent++ % QUERY_KINDS];
+        send(client, query.packet, query.length, 0);
+    }
+
+    double seconds = secondsSince(start);
+
+    printf("UDP loopback:  %.0f queries/s (%lu answered, %lu timeouts, window %d, responder saw %u)\n",
+           answered / seconds, answered, timeouts, WINDOW, dns.getQueryCount());
+
+    close(client);
+    dns.end();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : 5300;
+    Query queries[QUERY_KINDS];
+
+    for (int i = 0; i < QUERY_KINDS; i++) {
+        uint16_t type = (i & 1) ? TYPE_AAAA : TYPE_A;
+        queries[i].length = writeQuery(queries[i].packet, (uint16_t)i, NAMES[i / 2], type);
+    }
+
+    benchBuildResponse(queries);
+    return benchLoopback(queries, port) ? 0 : 1;
+}
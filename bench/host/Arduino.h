@@ -0,0 +1,118 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ================================
+// HOST ARDUINO SHIM
+// ================================
+
+// Just enough of the Arduino core and FreeRTOS for the benchmarks to build
+// firmware sources (json_writer.cpp, captive_dns.cpp) on Linux. String
+// grows the way the ESP32 core does: concat() reallocates to the exact new
+// length, so the reallocation counter shows whether a reserve() held.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <cerrno>
+#include <utility>
+
+using std::isnan;
+using std::isinf;
+
+unsigned long millis();
+unsigned long micros();
+
+// ================================
+// PRINT & STRING
+// ================================
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length);
+};
+
+struct StringStats {
+    uint32_t allocations;   // malloc/realloc of a String buffer
+    size_t bytes;           // Sum of the requested buffer sizes
+};
+
+extern StringStats stringStats;
+
+class String {
+public:
+    String(const char* text = "");
+    String(const String& other);
+    String(String&& other);
+    ~String();
+
+    String& operator=(const String& other);
+    String& operator=(String&& other);
+
+    explicit String(long number);
+
+    bool reserve(unsigned int size);
+    bool concat(char c);
+    bool concat(const char* data, unsigned int length);
+
+    String& operator+=(const char* text) { concat(text, strlen(text)); return *this; }
+    String& operator+=(const String& other) { concat(other.c_str(), other._length); return *this; }
+
+    const char* c_str() const { return _buffer ? _buffer : ""; }
+    unsigned int length() const { return _length; }
+
+private:
+    char* _buffer;
+    unsigned int _capacity;
+    unsigned int _length;
+
+    bool _grow(unsigned int size);
+};
+
+String operator+(const String& left, const char* right);
+String operator+(const char* left, const String& right);
+String operator+(const String& left, const String& right);
+
+// ================================
+// NETWORK & CHIP
+// ================================
+
+class IPAddress {
+public:
+    IPAddress() : _address{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+    uint8_t operator[](int index) const { return _address[index]; }
+
+private:
+    uint8_t _address[4];
+};
+
+class EspClass {
+public:
+    uint32_t getCycleCount();
+};
+
+extern EspClass ESP;
+
+// ================================
+// FREERTOS
+// ================================
+
+// Tasks run on std::thread; vTaskDelete(nullptr) is the thread returning
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdPASS 1
+#define pdMS_TO_TICKS(ms) (ms)
+
+BaseType_t xTaskCreatePinnedToCore(void (*function)(void*), const char* name, uint32_t stackSize,
+                                   void* parameter, unsigned priority, TaskHandle_t* handle, int core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t handle);
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,211 @@
+#include "Arduino.h"
+#include "heap_telemetry.h"
+#include <chrono>
+#include <cstdarg>
+#include <thread>
+#include <x86intrin.h>
+
+// ================================
+// TIME & CHIP
+// ================================
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)__rdtsc();
+}
+
+// ================================
+// PRINT & STRING
+// ================================
+
+size_t Print::write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+
+    while (written < length && write(data[written])) {
+        written++;
+    }
+
+    return written;
+}
+
+StringStats stringStats = { 0, 0 };
+
+String::String(const char* text) :
+    _buffer(nullptr),
+    _capacity(0),
+    _length(0)
+{
+    if (text && *text) {
+        concat(text, strlen(text));
+    }
+}
+
+String::String(const String& other) :
+    _buffer(nullptr),
+    _capacity(0),
+    _length(0)
+{
+    concat(other.c_str(), other._length);
+}
+
+String::String(String&& other) :
+    _buffer(other._buffer),
+    _capacity(other._capacity),
+    _length(other._length)
+{
+    other._buffer = nullptr;
+    other._capacity = 0;
+    other._length = 0;
+}
+
+String::String(long number) :
+    _buffer(nullptr),
+    _capacity(0),
+    _length(0)
+{
+    char digits[24];
+    concat(digits, snprintf(digits, sizeof(digits), "%ld", number));
+}
+
+String::~String() {
+    free(_buffer);
+}
+
+String& String::operator=(const String& other) {
+    if (this != &other) {
+        _length = 0;
+        concat(other.c_str(), other._length);
+    }
+
+    return *this;
+}
+
+String& String::operator=(String&& other) {
+    if (this != &other) {
+        free(_buffer);
+        _buffer = other._buffer;
+        _capacity = other._capacity;
+        _length = other._length;
+        other._buffer = nullptr;
+        other._capacity = 0;
+        other._length = 0;
+    }
+
+    return *this;
+}
+
+bool String::reserve(unsigned int size) {
+    return size <= _capacity || _grow(size);
+}
+
+bool String::concat(char c) {
+    return concat(&c, 1);
+}
+
+bool String::concat(const char* data, unsigned int length) {
+    // Exact-size growth, as in the ESP32 core's String::concat()
+    if (!reserve(_length + length)) {
+        return false;
+    }
+
+    memcpy(_buffer + _length, data, length);
+    _length += length;
+    _buffer[_length] = '\0';
+    return true;
+}
+
+String operator+(const String& left, const char* right) {
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const char* left, const String& right) {
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+String operator+(const String& left, const String& right) {
+    String sum(left);
+    sum += right;
+    return sum;
+}
+
+bool String::_grow(unsigned int size) {
+    char* buffer = (char*)realloc(_buffer, size + 1);
+
+    if (!buffer) {
+        return false;
+    }
+
+    stringStats.allocations++;
+    stringStats.bytes += size + 1;
+
+    _buffer = buffer;
+    _capacity = size;
+    return true;
+}
+
+// ================================
+// FREERTOS
+// ================================
+
+BaseType_t xTaskCreatePinnedToCore(void (*function)(void*), const char*, uint32_t,
+                                   void* parameter, unsigned, TaskHandle_t* handle, int) {
+    std::thread task(function, parameter);
+
+    if (handle) {
+        *handle = (TaskHandle_t)1;
+    }
+
+    task.detach();
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelete(TaskHandle_t) {
+}
+
+// ================================
+// FIRMWARE SERVICES
+// ================================
+
+// DEBUG_* backend; the benchmarks only print errors and warnings
+void logWrite(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void* heapAllocate(HeapTag, size_t size) {
+    return malloc(size);
+}
+
+void* heapReallocate(HeapTag, void* ptr, size_t size) {
+    return realloc(ptr, size);
+}
+
+void heapRelease(HeapTag, void* ptr) {
+    free(ptr);
+}
+
+void heapNote(HeapTag, size_t) {
+}
@@ -0,0 +1,210 @@
+// ================================
+// SCAN LIST JSON BENCHMARK
+// ================================
+
+// Host benchmark for the /api/scan body at 100 cached networks. It writes
+// the same fields as WiFiManager::getScannedNetworksJSON() through a
+// pre-sized JsonBuffer, and through the String concatenation the manager
+// used before, then reports time and String allocations per document.
+// It also checks the writer's escaping, that one reserve() covers the
+// whole document, and that a document outrunning it regrows geometrically.
+//
+// Build and run (from the repository root):
+//   g++ -std=gnu++11 -O2 -Ibench/host -Isrc -o /tmp/json_bench bench/json_bench.cpp bench/host/arduino_shim.cpp src/json_writer.cpp
+//   /tmp/json_bench
+
+#include "json_writer.h"
+#include <chrono>
+
+static const int NETWORK_COUNT = 100;
+static const long ROUNDS = 20000L;
+
+static const char* const ENCRYPTION_NAMES[] = {
+    "none", "WEP", "WPA", "WPA2", "WPA/WPA2", "WPA2-Enterprise"
+};
+
+// Mirrors ScanResult without the WiFi types
+struct ScanEntry {
+    char ssid[33];
+    uint8_t bssid[6];
+    int32_t rssi;
+    uint8_t channel;
+    uint8_t encryption;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    printf("  %-52s %s\n", what, condition ? "ok" : "FAILED");
+
+    if (!condition) {
+        failures++;
+    }
+}
+
+static void fillNetworks(ScanEntry* networks, bool quoted) {
+    for (int i = 0; i < NETWORK_COUNT; i++) {
+        ScanEntry& network = networks[i];
+
+        if (quoted) {
+            // Worst case: a full-length SSID where every character needs escaping
+            memset(network.ssid, '"', 32);
+            network.ssid[32] = '\0';
+        } else if (i % 10 == 0) {
+            snprintf(network.ssid, sizeof(network.ssid), "Cafe \"Guest\" %d", i);
+        } else {
+            snprintf(network.ssid, sizeof(network.ssid), "HomeNetwork-5G-%02d-ABCDEFGHIJ", i);
+        }
+
+        for (int b = 0; b < 6; b++) {
+            network.bssid[b] = (uint8_t)(i * 7 + b);
+        }
+
+        network.rssi = -30 - (i % 60);
+        network.channel = 1 + (i % 13);
+        network.encryption = i % 6;
+    }
+}
+
+// ================================
+// DOCUMENT BUILDERS
+// ================================
+
+// Same calls and estimate as WiFiManager::getScannedNetworksJSON()
+static String writerDocument(const ScanEntry* networks, int count) {
+    size_t estimate = 64;
+    for (int i = 0; i < count; i++) {
+        estimate += 96 + strlen(networks[i].ssid);
+    }
+
+    JsonBuffer buffer(estimate, HEAP_TAG_WIFI);
+    JsonWriter json(buffer);
+
+    json.beginObject();
+    json.beginArray("networks");
+
+    for (int i = 0; i < count; i++) {
+        const ScanEntry& network = networks[i];
+        json.beginObject();
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 network.bssid[0], network.bssid[1], network.bssid[2],
+                 network.bssid[3], network.bssid[4], network.bssid[5]);
+
+        json.field("ssid", network.ssid);
+        json.field("bssid", bssid);
+        json.field("rssi", network.rssi);
+        json.field("channel", network.channel);
+        json.field("encryption", ENCRYPTION_NAMES[network.encryption]);
+        json.endObject();
+    }
+
+    json.endArray();
+    json.field("scanning", false);
+    json.field("age_ms", 1234UL);
+    json.endObject();
+
+    return buffer.release();
+}
+
+// The previous String-concatenation style, with the same fields (no escaping)
+static String concatDocument(const ScanEntry* networks, int count) {
+    String json = "{\"networks\":[";
+
+    for (int i = 0; i < count; i++) {
+        const ScanEntry& network = networks[i];
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 network.bssid[0], network.bssid[1], network.bssid[2],
+                 network.bssid[3], network.bssid[4], network.bssid[5]);
+
+        if (i > 0) json += ",";
+
+        json += "{";
+        json += "\"ssid\":\"" + String(network.ssid) + "\",";
+        json += "\"bssid\":\"" + String(bssid) + "\",";
+        json += "\"rssi\":" + String((long)network.rssi) + ",";
+        json += "\"channel\":" + String((long)network.channel) + ",";
+        json += "\"encryption\":\"" + String(ENCRYPTION_NAMES[network.encryption]) + "\"";
+        json += "}";
+    }
+
+    json += "],\"scanning\":false,\"age_ms\":1234}";
+    return json;
+}
+
+// ================================
+// CHECKS
+// ================================
+
+static void checkEscaping() {
+    printf("Escaping:\n");
+
+    JsonBuffer buffer(64);
+    JsonWriter json(buffer);
+    json.beginObject();
+    json.field("ssid", "Say \"hi\" C:\\ \n\t\x01");
+    json.endObject();
+
+    String text = buffer.release();
+    check(strcmp(text.c_str(), "{\"ssid\":\"Say \\\"hi\\\" C:\\\\ \\n\\t\\u0001\"}") == 0,
+          "quotes, backslash and control characters");
+    check(json.bytesWritten() == text.length(), "bytesWritten() matches the output");
+}
+
+static void checkAllocations(const ScanEntry* networks, const ScanEntry* quoted) {
+    printf("Allocations at %d networks:\n", NETWORK_COUNT);
+
+    uint32_t before = stringStats.allocations;
+    String typical = writerDocument(networks, NETWORK_COUNT);
+    uint32_t typicalAllocations = stringStats.allocations - before;
+
+    before = stringStats.allocations;
+    String worst = writerDocument(quoted, NETWORK_COUNT);
+    uint32_t worstAllocations = stringStats.allocations - before;
+
+    check(typicalAllocations == 1, "typical SSIDs: one reservation, no regrowth");
+    check(worstAllocations <= 3, "escaped SSIDs: estimate exceeded, doubling regrowth");
+    printf("  typical document %u bytes\n", typical.length());
+    printf("  32 escaped quotes per SSID: %u bytes, %u allocations\n",
+           worst.length(), worstAllocations);
+}
+
+// ================================
+// TIMING
+// ================================
+
+template <typename Builder>
+static void timeBuilder(const char* name, Builder build, const ScanEntry* networks) {
+    size_t total = 0;
+    StringStats before = stringStats;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long round = 0; round < ROUNDS; round++) {
+        total += build(networks, NETWORK_COUNT).length();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("  %-20s %7.1f us/document  %6.1f allocations  %8.0f bytes allocated  (%lu bytes out)\n",
+           name, seconds * 1e6 / ROUNDS,
+           double(stringStats.allocations - before.allocations) / ROUNDS,
+           double(stringStats.bytes - before.bytes) / ROUNDS,
+           (unsigned long)(total / ROUNDS));
+}
+
+int main() {
+    static ScanEntry networks[NETWORK_COUNT];
+    static ScanEntry quoted[NETWORK_COUNT];
+    fillNetworks(networks, false);
+    fillNetworks(quoted, true);
+
+    checkEscaping();
+    checkAllocations(networks, quoted);
+
+    printf("Timing at %d networks:\n", NETWORK_COUNT);
+    timeBuilder("JsonWriter+Buffer", writerDocument, networks);
+    timeBuilder("String concat", concatDocument, networks);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+"""
+ESP32 Smart Captive Portal - web asset pipeline
+
+Minifies and gzips everything under web/, gives scripts and stylesheets
+content-hashed URLs and embeds the result in src/web_assets.h as PROGMEM
+byte arrays: the gzipped copy, plus the plain one for clients that do not
+accept gzip. Each copy gets an ETag hashed from its own bytes. Runs automatically as a PlatformIO pre-build script and can
+also be run by hand:  python scripts/build_web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ASSET_DIR = "web"
+OUTPUT_HEADER = os.path.join("src", "web_assets.h")
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+# Pages are served at fixed URLs; everything else gets a hashed, immutable URL
+PAGE_EXTENSIONS = (".html",)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    return "\n".join(line.strip() for line in text.splitlines() if line.strip())
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return re.sub(r"\s+", " ", text).strip()
+
+
+def minify_js(text):
+    # Conservative: only drop indentation, blank lines and whole-line comments
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+MINIFIERS = {
+    ".html": minify_html,
+    ".css": minify_css,
+    ".js": minify_js,
+}
+
+
+def c_identifier(name):
+    return "ASSET_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def load_assets(root):
+    assets = []
+    for name in sorted(os.listdir(os.path.join(root, ASSET_DIR))):
+        path = os.path.join(root, ASSET_DIR, name)
+        if not os.path.isfile(path):
+            continue
+
+        base, ext = os.path.splitext(name)
+        with open(path, "r", encoding="utf-8") as f:
+            text = f.read()
+
+        minify = MINIFIERS.get(ext)
+        assets.append({
+            "name": name,
+            "base": base,
+            "ext": ext,
+            "mime": MIME_TYPES.get(ext, "application/octet-stream"),
+            "text": minify(text) if minify else text,
+        })
+    return assets
+
+
+def build(root):
+    assets = load_assets(root)
+
+    # Hash sub-resources first so pages can reference their final URLs
+    for asset in assets:
+        if asset["ext"] not in PAGE_EXTENSIONS:
+            digest = hashlib.sha256(asset["text"].encode("utf-8")).hexdigest()[:10]
+            asset["url"] = "/assets/%s.%s%s" % (asset["base"], digest, asset["ext"])
+
+    for asset in assets:
+        if asset["ext"] in PAGE_EXTENSIONS:
+            for other in assets:
+                if "url" in other:
+                    asset["text"] = asset["text"].replace("/assets/" + other["name"], other["url"])
+            asset["url"] = "/" + asset["name"]
+
+    lines = [
+        "// Generated by scripts/build_web_assets.py from web/ - do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+
+    for asset in assets:
+        raw = asset["text"].encode("utf-8")
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+
+        # ETags identify the bytes actually sent, so each encoding has its own
+        asset["etag"] = '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+        asset["raw_etag"] = '"%s"' % hashlib.sha256(raw).hexdigest()[:16]
+        asset["ident"] = c_identifier(asset["name"])
+        asset["size"] = len(data)
+        asset["raw_size"] = len(raw)
+
+        lines.append("// %s: %d bytes minified, %d bytes gzipped" % (asset["name"], len(raw), len(data)))
+        for ident, payload in ((asset["ident"], data), (asset["ident"] + "_RAW", raw)):
+            lines.append("static const uint8_t %s[] PROGMEM = {" % ident)
+            for i in range(0, len(payload), 16):
+                lines.append("    " + ", ".join("0x%02x" % b for b in payload[i:i + 16]) + ",")
+            lines.append("};")
+        lines.append("")
+
+    lines += [
+        "struct WebAsset {",
+        "    const char* url;",
+        "    const char* mimeType;",
+        "    const uint8_t* data;        // gzip",
+        "    size_t length;",
+        "    const char* etag;",
+        "    const uint8_t* rawData;     // Uncompressed, for clients without gzip",
+        "    size_t rawLength;",
+        "    const char* rawEtag;",
+        "    bool immutable;",
+        "};",
+        "",
+        "static const WebAsset WEB_ASSETS[] = {",
+    ]
+    for asset in assets:
+        lines.append('    { "%s", "%s", %s, %d, "%s", %s_RAW, %d, "%s", %s },' % (
+            asset["url"], asset["mime"], asset["ident"], asset["size"],
+            asset["etag"].replace('"', '\\"'),
+            asset["ident"], asset["raw_size"],
+            asset["raw_etag"].replace('"', '\\"'),
+            "false" if asset["ext"] in PAGE_EXTENSIONS else "true"))
+    lines += [
+        "};",
+        "",
+        "static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);",
+        "",
+    ]
+
+    # X-macro of (index, url) pairs, expanded into the web server's route switch
+    lines.append("#define WEB_ASSET_ROUTES(ROUTE) \\")
+    for index, asset in enumerate(assets):
+        lines.append('    ROUTE(%d, "%s") \\' % (index, asset["url"]))
+    lines.append("")
+    lines.append("")
+
+    for asset in assets:
+        if asset["ext"] in PAGE_EXTENSIONS:
+            index = assets.index(asset)
+            lines.append("#define WEB_PAGE_%s (&WEB_ASSETS[%d])" % (re.sub(r"\W", "_", asset["base"]).upper(), index))
+
+    lines += ["", "#endif // WEB_ASSETS_H", ""]
+
+    output = os.path.join(root, OUTPUT_HEADER)
+    content = "\n".join(lines)
+
+    # Only touch the header when it changes, to avoid needless rebuilds
+    if os.path.exists(output):
+        with open(output, "r", encoding="utf-8") as f:
+            if f.read() == content:
+                return
+
+    with open(output, "w", encoding="utf-8") as f:
+        f.write(content)
+    print("Web assets: generated %s (%d files)" % (OUTPUT_HEADER, len(assets)))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    build(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,84 @@
+#include "api_fields.h"
+
+// ================================
+// FIELD NAME TABLE
+// ================================
+
+struct FieldName {
+    const char* name;
+    uint32_t mask;
+};
+
+static const FieldName FIELD_NAMES[] = {
+    // Individual keys
+    { "timestamp",         FIELD_TIMESTAMP },
+    { "temperature",       FIELD_TEMPERATURE },
+    { "humidity",          FIELD_HUMIDITY },
+    { "pressure",          FIELD_PRESSURE },
+    { "light_level",       FIELD_LIGHT_LEVEL },
+    { "motion_detected",   FIELD_MOTION_DETECTED },
+    { "battery_level",     FIELD_BATTERY_LEVEL },
+    { "uptime",            FIELD_UPTIME },
+    { "boot_count",        FIELD_BOOT_COUNT },
+    { "total_connections", FIELD_TOTAL_CONNECTIONS },
+    { "free_heap",         FIELD_FREE_HEAP },
+    { "total_heap",        FIELD_TOTAL_HEAP },
+    { "heap_usage",        FIELD_HEAP_USAGE },
+    { "wifi_ssid",         FIELD_WIFI_SSID },
+    { "wifi_rssi",         FIELD_WIFI_RSSI },
+    { "local_ip",          FIELD_LOCAL_IP },
+    { "mac_address",       FIELD_MAC_ADDRESS },
+    { "chip_temperature",  FIELD_CHIP_TEMPERATURE },
+    { "led_state",         FIELD_LED_STATE },
+    { "websocket_clients", FIELD_WEBSOCKET_CLIENTS },
+    { "cpu_usage",         FIELD_CPU_USAGE },
+    { "heap_health",       FIELD_HEAP_HEALTH },
+    { "heap_tags",         FIELD_HEAP_TAGS },
+    { "server",            FIELD_SERVER },
+
+    // Groups
+    { "sensors",           FIELD_GROUP_SENSORS },
+    { "heap",              FIELD_GROUP_HEAP },
+    { "wifi",              FIELD_GROUP_WIFI },
+    { "device",            FIELD_GROUP_DEVICE },
+    { "all",               FIELD_ALL }
+};
+
+static uint32_t _lookupField(const char* name, size_t length) {
+    for (const FieldName& field : FIELD_NAMES) {
+        if (strlen(field.name) == length && strncmp(field.name, name, length) == 0) {
+            return field.mask;
+        }
+    }
+
+    return 0;
+}
+
+// ================================
+// PARSER
+// ================================
+
+uint32_t parseFieldMask(const String& fieldList) {
+    if (fieldList.length() == 0) {
+        return FIELD_ALL;
+    }
+
+    uint32_t mask = 0;
+    const char* token = fieldList.c_str();
+
+    while (*token) {
+        // Skip separators and whitespace
+        while (*token == ',' || *token == ' ') {
+            token++;
+        }
+
+        size_t length = strcspn(token, ", ");
+        if (length > 0) {
+            mask |= _lookupField(token, length);
+        }
+
+        token += length;
+    }
+
+    return mask;
+}
@@ -0,0 +1,57 @@
+#ifndef API_FIELDS_H
+#define API_FIELDS_H
+
+#include <Arduino.h>
+
+// ================================
+// API FIELD PROJECTION
+// ================================
+
+// One bit per top-level key of the sensor, device stats and status payloads.
+// A "?fields=" list is parsed once per request into a mask; serialisers skip
+// (and avoid computing) anything whose bit is not set.
+enum ApiField : uint32_t {
+    // Sensor data
+    FIELD_TIMESTAMP         = 1UL << 0,
+    FIELD_TEMPERATURE       = 1UL << 1,
+    FIELD_HUMIDITY          = 1UL << 2,
+    FIELD_PRESSURE          = 1UL << 3,
+    FIELD_LIGHT_LEVEL       = 1UL << 4,
+    FIELD_MOTION_DETECTED   = 1UL << 5,
+    FIELD_BATTERY_LEVEL     = 1UL << 6,
+
+    // Device statistics
+    FIELD_UPTIME            = 1UL << 8,
+    FIELD_BOOT_COUNT        = 1UL << 9,
+    FIELD_TOTAL_CONNECTIONS = 1UL << 10,
+    FIELD_FREE_HEAP         = 1UL << 11,
+    FIELD_TOTAL_HEAP        = 1UL << 12,
+    FIELD_HEAP_USAGE        = 1UL << 13,
+    FIELD_WIFI_SSID         = 1UL << 14,
+    FIELD_WIFI_RSSI         = 1UL << 15,
+    FIELD_LOCAL_IP          = 1UL << 16,
+    FIELD_MAC_ADDRESS       = 1UL << 17,
+    FIELD_CHIP_TEMPERATURE  = 1UL << 18,
+    FIELD_LED_STATE         = 1UL << 19,
+    FIELD_WEBSOCKET_CLIENTS = 1UL << 20,
+    FIELD_CPU_USAGE         = 1UL << 21,
+    FIELD_HEAP_HEALTH       = 1UL << 22,
+    FIELD_HEAP_TAGS         = 1UL << 23,
+
+    // Status sections
+    FIELD_SERVER            = 1UL << 24
+};
+
+// Field groups
+#define FIELD_GROUP_SENSORS   0x0000007FUL
+#define FIELD_GROUP_HEAP      (FIELD_FREE_HEAP | FIELD_TOTAL_HEAP | FIELD_HEAP_USAGE | \
+                               FIELD_HEAP_HEALTH | FIELD_HEAP_TAGS)
+#define FIELD_GROUP_WIFI      (FIELD_WIFI_SSID | FIELD_WIFI_RSSI | FIELD_LOCAL_IP | FIELD_MAC_ADDRESS)
+#define FIELD_GROUP_DEVICE    0x00FFFF00UL
+#define FIELD_ALL             0xFFFFFFFFUL
+
+// Parse a comma separated field list ("temperature,battery_level,wifi").
+// An empty list selects every field; unknown names are ignored.
+uint32_t parseFieldMask(const String& fieldList);
+
+#endif // API_FIELDS_H
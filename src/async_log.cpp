@@ -0,0 +1,473 @@
+#include "async_log.h"
+#include "config.h"
+#include <stdarg.h>
+#include <stddef.h>
+
+#if (LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) || LOG_BUFFER_SIZE > 65536
+#error "LOG_BUFFER_SIZE must be a power of two no larger than 64 KB"
+#endif
+
+// ================================
+// RECORD FORMAT
+// ================================
+
+// A record is a header followed by the arguments in format order. Records
+// are contiguous and 4-byte aligned; the tail of the ring that is too short
+// for the next record is covered by a padding record.
+struct LogHeader {
+    uint16_t size;          // Whole record, header included
+    uint8_t ready;          // Set once the producer has copied the record in
+    uint8_t flags;
+    uint16_t conversions;   // Conversions whose arguments were stored
+    const char* format;
+};
+
+#define LOG_RECORD_PADDING      0x01
+#define LOG_RECORD_TRUNCATED    0x02
+#define LOG_RECORD_PREFIX       4       // size, ready and flags
+#define LOG_SPEC_LENGTH         16
+
+enum LogArgType : uint8_t {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LONG_LONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_POINTER,
+    ARG_STRING,
+    ARG_PERCENT,
+    ARG_INVALID
+};
+
+// ================================
+// RING STATE
+// ================================
+
+// Producers reserve space under the lock (a few compares and stores) and
+// copy their record outside it; the drain task is the only consumer
+static portMUX_TYPE _logLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t _ring[LOG_BUFFER_SIZE] __attribute__((aligned(4)));
+static uint32_t _head;          // Free-running, written under the lock
+static uint32_t _tail;          // Free-running, written by the drain task
+static TaskHandle_t _drainTask = nullptr;
+
+static LogStats _stats;
+
+// ================================
+// FORMAT PARSING
+// ================================
+
+// Parses one conversion; p points just past the '%'. Returns the end of
+// the conversion and the argument type, plus the number of '*' width and
+// precision arguments that come before the value.
+static const char* _parseSpec(const char* p, LogArgType& type, uint8_t& stars) {
+    LogArgType integer = ARG_INT;
+    stars = 0;
+
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+
+    if (*p == '*') {
+        stars++;
+        p++;
+    } else {
+        while (isdigit((unsigned char)*p)) p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            stars++;
+            p++;
+        } else {
+            while (isdigit((unsigned char)*p)) p++;
+        }
+    }
+
+    if (*p == 'h') {
+        p++;
+        if (*p == 'h') p++;
+    } else if (*p == 'l') {
+        p++;
+        integer = ARG_LONG;
+        if (*p == 'l') {
+            p++;
+            integer = ARG_LONG_LONG;
+        }
+    } else if (*p == 'j') {
+        p++;
+        integer = ARG_INTMAX;
+    } else if (*p == 'z' || *p == 't') {
+        p++;
+        integer = ARG_SIZE;
+    }
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            type = integer;
+            break;
+        case 'c':
+            type = ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            type = ARG_DOUBLE;
+            break;
+        case 's':
+            type = ARG_STRING;
+            break;
+        case 'p':
+            type = ARG_POINTER;
+            break;
+        case '%':
+            type = ARG_PERCENT;
+            break;
+        default:
+            // %n, long double and anything unknown end the line here
+            type = ARG_INVALID;
+            return p;
+    }
+
+    return p + 1;
+}
+
+// ================================
+// ENCODING
+// ================================
+
+template <typename T>
+static bool _put(uint8_t* record, size_t& length, T value) {
+    if (length + sizeof(T) > LOG_MAX_RECORD_SIZE) {
+        return false;
+    }
+
+    memcpy(record + length, &value, sizeof(T));
+    length += sizeof(T);
+    return true;
+}
+
+static bool _putString(uint8_t* record, size_t& length, const char* value) {
+    if (!value) {
+        value = "(null)";
+    }
+
+    size_t room = LOG_MAX_RECORD_SIZE - length;
+    if (room == 0) {
+        return false;
+    }
+
+    // Keep what fits; the caller flags the record as truncated
+    size_t copied = strnlen(value, room - 1);
+    memcpy(record + length, value, copied);
+    record[length + copied] = '\0';
+    length += copied + 1;
+    return value[copied] == '\0';
+}
+
+// Copies the arguments the format refers to into the record. Returns
+// false when they did not all fit.
+static bool _encode(uint8_t* record, size_t& length, uint16_t& conversions, const char* format, va_list args) {
+    const char* p = format;
+
+    while ((p = strchr(p, '%'))) {
+        LogArgType type;
+        uint8_t stars;
+        p = _parseSpec(p + 1, type, stars);
+
+        if (type == ARG_PERCENT) {
+            continue;
+        }
+
+        if (type == ARG_INVALID) {
+            return true;
+        }
+
+        for (uint8_t i = 0; i < stars; i++) {
+            if (!_put(record, length, va_arg(args, int))) {
+                return false;
+            }
+        }
+
+        if (type == ARG_STRING) {
+            size_t start = length;
+            bool complete = _putString(record, length, va_arg(args, const char*));
+
+            // A cut string is still printed
+            if (length > start) {
+                conversions++;
+            }
+
+            if (!complete) {
+                return false;
+            }
+            continue;
+        }
+
+        bool stored;
+        switch (type) {
+            case ARG_INT:       stored = _put(record, length, va_arg(args, int)); break;
+            case ARG_LONG:      stored = _put(record, length, va_arg(args, long)); break;
+            case ARG_LONG_LONG: stored = _put(record, length, va_arg(args, long long)); break;
+            case ARG_INTMAX:    stored = _put(record, length, va_arg(args, intmax_t)); break;
+            case ARG_SIZE:      stored = _put(record, length, va_arg(args, size_t)); break;
+            case ARG_DOUBLE:    stored = _put(record, length, va_arg(args, double)); break;
+            default:            stored = _put(record, length, va_arg(args, void*)); break;
+        }
+
+        if (!stored) {
+            return false;
+        }
+
+        conversions++;
+    }
+
+    return true;
+}
+
+// ================================
+// DECODING
+// ================================
+
+template <typename T>
+static T _take(const uint8_t*& cursor) {
+    T value;
+    memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+template <typename T>
+static int _formatArg(char* out, size_t room, const char* spec, const int* stars, uint8_t starCount, T value) {
+    switch (starCount) {
+        case 0:  return snprintf(out, room, spec, value);
+        case 1:  return snprintf(out, room, spec, stars[0], value);
+        default: return snprintf(out, room, spec, stars[0], stars[1], value);
+    }
+}
+
+// Formats one record into line; the result always ends in a newline
+static size_t _decode(const LogHeader& header, const uint8_t* cursor, char* line, size_t capacity) {
+    const char* p = header.format;
+    uint16_t remaining = header.conversions;
+    size_t length = 0;
+
+    // One byte is kept back for the newline
+    while (*p && length < capacity - 2) {
+        if (*p != '%') {
+            line[length++] = *p++;
+            continue;
+        }
+
+        const char* start = p;
+        LogArgType type;
+        uint8_t starCount;
+        p = _parseSpec(p + 1, type, starCount);
+
+        if (type == ARG_PERCENT) {
+            line[length++] = '%';
+            continue;
+        }
+
+        if (type == ARG_INVALID || remaining == 0 || (size_t)(p - start) >= LOG_SPEC_LENGTH) {
+            break;
+        }
+
+        char spec[LOG_SPEC_LENGTH];
+        memcpy(spec, start, p - start);
+        spec[p - start] = '\0';
+
+        int stars[2];
+        for (uint8_t i = 0; i < starCount; i++) {
+            stars[i] = _take<int>(cursor);
+        }
+
+        char* out = line + length;
+        size_t room = capacity - 1 - length;
+        int written;
+
+        switch (type) {
+            case ARG_INT:       written = _formatArg(out, room, spec, stars, starCount, _take<int>(cursor)); break;
+            case ARG_LONG:      written = _formatArg(out, room, spec, stars, starCount, _take<long>(cursor)); break;
+            case ARG_LONG_LONG: written = _formatArg(out, room, spec, stars, starCount, _take<long long>(cursor)); break;
+            case ARG_INTMAX:    written = _formatArg(out, room, spec, stars, starCount, _take<intmax_t>(cursor)); break;
+            case ARG_SIZE:      written = _formatArg(out, room, spec, stars, starCount, _take<size_t>(cursor)); break;
+            case ARG_DOUBLE:    written = _formatArg(out, room, spec, stars, starCount, _take<double>(cursor)); break;
+            case ARG_POINTER:   written = _formatArg(out, room, spec, stars, starCount, _take<void*>(cursor)); break;
+            default: {
+                const char* value = reinterpret_cast<const char*>(cursor);
+                cursor += strlen(value) + 1;
+                written = _formatArg(out, room, spec, stars, starCount, value);
+                break;
+            }
+        }
+
+        if (written > 0) {
+            length += (size_t)written < room ? written : room - 1;
+        }
+
+        remaining--;
+    }
+
+    if (length == 0 || line[length - 1] != '\n') {
+        line[length++] = '\n';
+    }
+
+    return length;
+}
+
+// ================================
+// RING BUFFER
+// ================================
+
+// Reserves size contiguous bytes; returns their offset or -1 when full
+static int32_t _reserve(size_t size) {
+    int32_t offset = -1;
+
+    portENTER_CRITICAL(&_logLock);
+
+    uint32_t position = _head & (LOG_BUFFER_SIZE - 1);
+    uint32_t contiguous = LOG_BUFFER_SIZE - position;
+    uint32_t padding = size > contiguous ? contiguous : 0;
+    uint32_t used = _head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+
+    if (used + padding + size <= LOG_BUFFER_SIZE) {
+        if (padding) {
+            LogHeader pad = { (uint16_t)padding, 1, LOG_RECORD_PADDING, 0, nullptr };
+            memcpy(_ring + position, &pad, LOG_RECORD_PREFIX);
+            position = 0;
+        }
+
+        // The slot reads as not ready until the producer publishes it
+        _ring[position + offsetof(LogHeader, ready)] = 0;
+        __atomic_store_n(&_head, _head + padding + size, __ATOMIC_RELEASE);
+
+        if (used + padding + size > _stats.peakBytes) {
+            _stats.peakBytes = used + padding + size;
+        }
+
+        offset = position;
+    } else {
+        _stats.dropped++;
+    }
+
+    portEXIT_CRITICAL(&_logLock);
+    return offset;
+}
+
+// Formats and releases the oldest published record. Returns false when
+// there is none yet.
+static bool _drainOne(char* line, size_t& length) {
+    uint32_t tail = _tail;
+    length = 0;
+
+    if (tail == __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    uint8_t* record = _ring + (tail & (LOG_BUFFER_SIZE - 1));
+    if (!__atomic_load_n(record + offsetof(LogHeader, ready), __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    LogHeader header;
+    memcpy(&header, record, LOG_RECORD_PREFIX);
+
+    if (!(header.flags & LOG_RECORD_PADDING)) {
+        memcpy(&header, record, sizeof(header));
+        length = _decode(header, record + sizeof(header), line, LOG_LINE_LENGTH);
+    }
+
+    // Release the space before the slow serial write
+    __atomic_store_n(&_tail, tail + header.size, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void _drainTaskEntry(void* parameter) {
+    char line[LOG_LINE_LENGTH];
+    uint32_t reportedDrops = 0;
+
+    for (;;) {
+        size_t length;
+
+        while (_drainOne(line, length)) {
+            if (length) {
+                Serial.write(reinterpret_cast<const uint8_t*>(line), length);
+                _stats.lines++;
+            }
+        }
+
+        uint32_t dropped = _stats.dropped;
+        if (dropped != reportedDrops) {
+            Serial.printf("[WARN] %u log lines dropped\n", (unsigned)(dropped - reportedDrops));
+            reportedDrops = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+// ================================
+// PUBLIC API
+// ================================
+
+bool logBegin() {
+    if (_drainTask) {
+        return true;
+    }
+
+    if (xTaskCreatePinnedToCore(_drainTaskEntry, "log", LOG_TASK_STACK_SIZE, nullptr,
+                                LOG_TASK_PRIORITY, &_drainTask, LOG_TASK_CORE) != pdPASS) {
+        _drainTask = nullptr;
+        Serial.println("[ERROR] Failed to start log task, logging synchronously");
+        return false;
+    }
+
+    return true;
+}
+
+void logWrite(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    if (!_drainTask) {
+        char line[LOG_LINE_LENGTH];
+        int length = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+
+        if (length > 0) {
+            Serial.write(reinterpret_cast<const uint8_t*>(line), min((size_t)length, sizeof(line) - 1));
+            _stats.lines++;
+        }
+        return;
+    }
+
+    uint8_t record[LOG_MAX_RECORD_SIZE] __attribute__((aligned(4)));
+    size_t length = sizeof(LogHeader);
+    LogHeader header = { 0, 0, 0, 0, format };
+
+    if (!_encode(record, length, header.conversions, format, args)) {
+        header.flags |= LOG_RECORD_TRUNCATED;
+        length = min(length, (size_t)LOG_MAX_RECORD_SIZE);
+        portENTER_CRITICAL(&_logLock);
+        _stats.truncated++;
+        portEXIT_CRITICAL(&_logLock);
+    }
+
+    va_end(args);
+
+    header.size = (length + 3) & ~3;
+    memcpy(record, &header, sizeof(header));
+
+    int32_t offset = _reserve(header.size);
+    if (offset < 0) {
+        return;
+    }
+
+    memcpy(_ring + offset, record, length);
+    __atomic_store_n(_ring + offset + offsetof(LogHeader, ready), (uint8_t)1, __ATOMIC_RELEASE);
+}
+
+LogStats getLogStats() {
+    return _stats;
+}
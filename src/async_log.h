@@ -0,0 +1,29 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <Arduino.h>
+
+// ================================
+// ASYNCHRONOUS LOGGING
+// ================================
+
+// Backend for the DEBUG_* macros. logWrite() stores the format pointer and
+// the raw arguments (strings copied) in a ring buffer and returns; a low
+// priority task formats the lines and writes them to the serial port.
+// The format must be a string literal, which the macros guarantee.
+
+struct LogStats {
+    uint32_t lines;         // Written to the serial port
+    uint32_t dropped;       // Ring full at the time of the call
+    uint32_t truncated;     // Arguments did not fit in one record
+    size_t peakBytes;       // Most of the ring in use at once
+};
+
+// Start the drain task; until then lines are written synchronously
+bool logBegin();
+
+void logWrite(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+LogStats getLogStats();
+
+#endif // ASYNC_LOG_H
@@ -0,0 +1,206 @@
+#include "block_pool.h"
+#include "heap_telemetry.h"
+
+// One lock for all pools; critical sections are a few pointer moves
+static portMUX_TYPE _poolLock = portMUX_INITIALIZER_UNLOCKED;
+
+// ================================
+// FIXED-BLOCK POOL
+// ================================
+
+BlockPool::BlockPool() :
+    _memory(nullptr),
+    _blockSize(0),
+    _blockCount(0),
+    _freeList(nullptr),
+    _inUse(0),
+    _peakInUse(0),
+    _allocations(0),
+    _exhausted(0)
+{
+}
+
+bool BlockPool::begin(size_t blockSize, uint16_t blockCount) {
+    // Keep every block pointer-aligned for the free list and for ArduinoJson
+    blockSize = (blockSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+    _memory = static_cast<uint8_t*>(heapAllocate(HEAP_TAG_JSON, blockSize * blockCount));
+    if (!_memory) {
+        DEBUG_E("Failed to reserve %u x %u byte pool", blockCount, blockSize);
+        return false;
+    }
+
+    _blockSize = blockSize;
+    _blockCount = blockCount;
+
+    // Thread the free list through the blocks
+    for (uint16_t i = 0; i < blockCount; i++) {
+        void* block = _memory + i * blockSize;
+        *static_cast<void**>(block) = _freeList;
+        _freeList = block;
+    }
+
+    return true;
+}
+
+void* BlockPool::allocate() {
+    portENTER_CRITICAL(&_poolLock);
+    void* block = _freeList;
+
+    if (block) {
+        _freeList = *static_cast<void**>(block);
+        _allocations++;
+
+        if (++_inUse > _peakInUse) {
+            _peakInUse = _inUse;
+        }
+    }
+
+    portEXIT_CRITICAL(&_poolLock);
+    return block;
+}
+
+void BlockPool::release(void* block) {
+    portENTER_CRITICAL(&_poolLock);
+    *static_cast<void**>(block) = _freeList;
+    _freeList = block;
+    _inUse--;
+    portEXIT_CRITICAL(&_poolLock);
+}
+
+bool BlockPool::owns(const void* ptr) const {
+    const uint8_t* address = static_cast<const uint8_t*>(ptr);
+    return _memory && address >= _memory && address < _memory + _blockSize * _blockCount;
+}
+
+size_t BlockPool::getBlockSize() const {
+    return _blockSize;
+}
+
+uint16_t BlockPool::getBlockCount() const {
+    return _blockCount;
+}
+
+uint16_t BlockPool::getInUse() const {
+    return _inUse;
+}
+
+uint16_t BlockPool::getPeakInUse() const {
+    return _peakInUse;
+}
+
+uint32_t BlockPool::getAllocations() const {
+    return _allocations;
+}
+
+uint32_t BlockPool::getExhaustedCount() const {
+    return _exhausted;
+}
+
+void BlockPool::noteExhausted() {
+    portENTER_CRITICAL(&_poolLock);
+    _exhausted++;
+    portEXIT_CRITICAL(&_poolLock);
+}
+
+// ================================
+// SIZE-CLASS POOLS
+// ================================
+
+static BlockPool _pools[POOL_CLASS_COUNT];
+static uint32_t _oversize = 0;
+
+bool beginBlockPools() {
+    const size_t sizes[POOL_CLASS_COUNT] = POOL_BLOCK_SIZES;
+    const uint16_t counts[POOL_CLASS_COUNT] = POOL_BLOCK_COUNTS;
+    bool ok = true;
+
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        ok = _pools[i].begin(sizes[i], counts[i]) && ok;
+    }
+
+    DEBUG_I("Block pools reserved, %u bytes free", ESP.getFreeHeap());
+    return ok;
+}
+
+// The pool that owns a pointer, or nullptr for heap blocks
+static BlockPool* _owner(const void* ptr) {
+    for (BlockPool& pool : _pools) {
+        if (pool.owns(ptr)) {
+            return &pool;
+        }
+    }
+
+    return nullptr;
+}
+
+void* poolAllocate(size_t size) {
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        if (_pools[i].getBlockSize() < size) {
+            continue;
+        }
+
+        // Fits this class: take the first free block here or in a larger one
+        for (uint8_t j = i; j < POOL_CLASS_COUNT; j++) {
+            void* block = _pools[j].allocate();
+            if (block) {
+                return block;
+            }
+        }
+
+        _pools[i].noteExhausted();
+        return heapAllocate(HEAP_TAG_JSON, size);
+    }
+
+    portENTER_CRITICAL(&_poolLock);
+    _oversize++;
+    portEXIT_CRITICAL(&_poolLock);
+    return heapAllocate(HEAP_TAG_JSON, size);
+}
+
+void* poolReallocate(void* ptr, size_t size) {
+    if (!ptr) {
+        return poolAllocate(size);
+    }
+
+    BlockPool* pool = _owner(ptr);
+
+    if (!pool) {
+        return heapReallocate(HEAP_TAG_JSON, ptr, size);
+    }
+
+    // Shrinking (ArduinoJson's shrinkToFit) keeps the block
+    if (size <= pool->getBlockSize()) {
+        return ptr;
+    }
+
+    void* resized = poolAllocate(size);
+    if (resized) {
+        memcpy(resized, ptr, pool->getBlockSize());
+        pool->release(ptr);
+    }
+
+    return resized;
+}
+
+void poolRelease(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    BlockPool* pool = _owner(ptr);
+
+    if (pool) {
+        pool->release(ptr);
+    } else {
+        heapRelease(HEAP_TAG_JSON, ptr);
+    }
+}
+
+const BlockPool& getBlockPool(uint8_t sizeClass) {
+    return _pools[sizeClass];
+}
+
+uint32_t getPoolOversizeCount() {
+    return _oversize;
+}
@@ -0,0 +1,79 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+// ================================
+// FIXED-BLOCK POOL
+// ================================
+
+// Equal-sized blocks carved from one allocation made at boot. Free blocks
+// form an intrusive list, so allocate and release are O(1) and never touch
+// the general heap. Safe from any task.
+class BlockPool {
+public:
+    BlockPool();
+
+    bool begin(size_t blockSize, uint16_t blockCount);
+
+    void* allocate();
+    void release(void* block);
+    bool owns(const void* ptr) const;
+
+    size_t getBlockSize() const;
+    uint16_t getBlockCount() const;
+    uint16_t getInUse() const;
+    uint16_t getPeakInUse() const;
+    uint32_t getAllocations() const;
+    uint32_t getExhaustedCount() const;
+
+    // A request for this class found no free block in it or any larger one
+    void noteExhausted();
+
+private:
+    uint8_t* _memory;
+    size_t _blockSize;
+    uint16_t _blockCount;
+    void* _freeList;
+    uint16_t _inUse;
+    uint16_t _peakInUse;
+    uint32_t _allocations;
+    uint32_t _exhausted;
+};
+
+// ================================
+// SIZE-CLASS POOLS
+// ================================
+
+// Reserve every class from POOL_BLOCK_SIZES / POOL_BLOCK_COUNTS
+bool beginBlockPools();
+
+// Smallest free block that fits, falling back to the heap (counted as
+// exhaustion, or as oversize past the largest class)
+void* poolAllocate(size_t size);
+void* poolReallocate(void* ptr, size_t size);
+void poolRelease(void* ptr);
+
+const BlockPool& getBlockPool(uint8_t sizeClass);
+uint32_t getPoolOversizeCount();
+
+// ArduinoJson allocator drawing document pools from the block pools
+struct PooledJsonAllocator {
+    void* allocate(size_t size) {
+        return poolAllocate(size);
+    }
+
+    void deallocate(void* ptr) {
+        poolRelease(ptr);
+    }
+
+    void* reallocate(void* ptr, size_t size) {
+        return poolReallocate(ptr, size);
+    }
+};
+
+typedef BasicJsonDocument<PooledJsonAllocator> PooledJsonDocument;
+
+#endif // BLOCK_POOL_H
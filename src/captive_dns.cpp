@@ -0,0 +1,257 @@
+#include "captive_dns.h"
+#include <lwip/sockets.h>
+
+// DNS wire format
+#define DNS_HEADER_SIZE           12
+#define DNS_TYPE_A                1
+#define DNS_TYPE_ANY              255
+#define DNS_CLASS_IN              1
+#define DNS_RCODE_FORMERR         1
+#define DNS_RCODE_NOTIMP          4
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+CaptiveDNS::CaptiveDNS() :
+    _socket(-1),
+    _task(nullptr),
+    _running(false),
+    _queryCount(0),
+    _answerCount(0),
+    _emptyCount(0),
+    _droppedCount(0),
+    _busyCycles(0)
+{
+    memset(_answer, 0, sizeof(_answer));
+}
+
+CaptiveDNS::~CaptiveDNS() {
+    end();
+}
+
+bool CaptiveDNS::begin(const IPAddress& address, uint16_t port) {
+    if (_running) {
+        return true;
+    }
+
+    _buildAnswerTemplate(address);
+
+    _socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (_socket < 0) {
+        DEBUG_E("DNS socket creation failed: %d", errno);
+        return false;
+    }
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(_socket, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        DEBUG_E("DNS socket bind to port %u failed: %d", port, errno);
+        close(_socket);
+        _socket = -1;
+        return false;
+    }
+
+    // Bounded wait so the task notices end() without a wakeup packet
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = DNS_RECV_TIMEOUT_MS * 1000;
+    setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    _running = true;
+
+    if (xTaskCreatePinnedToCore(_taskEntry, "captive_dns", DNS_TASK_STACK_SIZE, this,
+                                DNS_TASK_PRIORITY, &_task, DNS_TASK_CORE) != pdPASS) {
+        DEBUG_E("Failed to start DNS task");
+        _running = false;
+        _task = nullptr;
+        close(_socket);
+        _socket = -1;
+        return false;
+    }
+
+    DEBUG_I("Captive DNS responder listening on port %u", port);
+    return true;
+}
+
+void CaptiveDNS::end() {
+    if (!_running) {
+        return;
+    }
+
+    _running = false;
+
+    // The task closes the socket and clears its handle on the way out
+    while (_task) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    DEBUG_I("Captive DNS responder stopped (%u queries)", _queryCount);
+}
+
+bool CaptiveDNS::isRunning() const {
+    return _running;
+}
+
+// ================================
+// STATISTICS
+// ================================
+
+uint32_t CaptiveDNS::getQueryCount() const {
+    return _queryCount;
+}
+
+uint32_t CaptiveDNS::getAnswerCount() const {
+    return _answerCount;
+}
+
+uint32_t CaptiveDNS::getEmptyCount() const {
+    return _emptyCount;
+}
+
+uint32_t CaptiveDNS::getDroppedCount() const {
+    return _droppedCount;
+}
+
+uint32_t CaptiveDNS::getBusyCycles() const {
+    return _busyCycles;
+}
+
+// ================================
+// PACKET HANDLING
+// ================================
+
+size_t CaptiveDNS::buildResponse(uint8_t* packet, size_t length, size_t capacity) {
+    if (length < DNS_HEADER_SIZE) {
+        return 0;
+    }
+
+    // Ignore responses; only standard queries (opcode 0) are answered
+    if (packet[2] & 0x80) {
+        return 0;
+    }
+
+    if (packet[2] & 0x78) {
+        return _buildErrorResponse(packet, DNS_RCODE_NOTIMP);
+    }
+
+    if (packet[4] != 0 || packet[5] != 1) {
+        return _buildErrorResponse(packet, DNS_RCODE_FORMERR);
+    }
+
+    // Walk the question name; compression is not valid in the first name
+    size_t pos = DNS_HEADER_SIZE;
+    while (pos < length && packet[pos] != 0) {
+        if (packet[pos] & 0xC0) {
+            return 0;
+        }
+        pos += packet[pos] + 1;
+    }
+
+    // Terminating zero, QTYPE and QCLASS
+    if (pos + 5 > length) {
+        return 0;
+    }
+
+    uint16_t qtype = (packet[pos + 1] << 8) | packet[pos + 2];
+    uint16_t qclass = (packet[pos + 3] << 8) | packet[pos + 4];
+    size_t questionEnd = pos + 5;
+
+    // QR + AA, keep RD; RA + NOERROR
+    packet[2] = 0x84 | (packet[2] & 0x01);
+    packet[3] = 0x80;
+
+    // Single question, no authority or additional records (drops EDNS OPT)
+    packet[6] = 0;
+    packet[7] = 0;
+    memset(packet + 8, 0, 4);
+
+    if ((qtype == DNS_TYPE_A || qtype == DNS_TYPE_ANY) && qclass == DNS_CLASS_IN) {
+        if (questionEnd + DNS_ANSWER_SIZE > capacity) {
+            return 0;
+        }
+
+        memcpy(packet + questionEnd, _answer, DNS_ANSWER_SIZE);
+        packet[7] = 1;
+        _answerCount++;
+        return questionEnd + DNS_ANSWER_SIZE;
+    }
+
+    // AAAA, HTTPS and everything else: empty answer so clients fall back to A fast
+    _emptyCount++;
+    return questionEnd;
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void CaptiveDNS::_taskEntry(void* parameter) {
+    static_cast<CaptiveDNS*>(parameter)->_run();
+}
+
+void CaptiveDNS::_run() {
+    uint8_t packet[DNS_MAX_PACKET_SIZE + DNS_ANSWER_SIZE];
+    struct sockaddr_in client;
+    socklen_t clientLength;
+
+    while (_running) {
+        // Block for the first datagram, then drain whatever else is queued
+        int flags = 0;
+
+        while (_running) {
+            clientLength = sizeof(client);
+            int length = recvfrom(_socket, packet, DNS_MAX_PACKET_SIZE, flags,
+                                  (struct sockaddr*)&client, &clientLength);
+            if (length < 0) {
+                break;
+            }
+
+            flags = MSG_DONTWAIT;
+            _queryCount++;
+
+            uint32_t start = ESP.getCycleCount();
+            size_t responseLength = buildResponse(packet, length, sizeof(packet));
+
+            if (responseLength == 0) {
+                _droppedCount++;
+            } else {
+                sendto(_socket, packet, responseLength, 0, (struct sockaddr*)&client, clientLength);
+            }
+
+            _busyCycles += ESP.getCycleCount() - start;
+        }
+    }
+
+    close(_socket);
+    _socket = -1;
+    _task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void CaptiveDNS::_buildAnswerTemplate(const IPAddress& address) {
+    const uint32_t ttl = DNS_ANSWER_TTL;
+    const uint8_t answer[DNS_ANSWER_SIZE] = {
+        0xC0, 0x0C,                                   // Pointer to the question name
+        0x00, DNS_TYPE_A,
+        0x00, DNS_CLASS_IN,
+        (uint8_t)(ttl >> 24), (uint8_t)(ttl >> 16), (uint8_t)(ttl >> 8), (uint8_t)ttl,
+        0x00, 0x04,
+        address[0], address[1], address[2], address[3]
+    };
+
+    memcpy(_answer, answer, sizeof(_answer));
+}
+
+size_t CaptiveDNS::_buildErrorResponse(uint8_t* packet, uint8_t rcode) {
+    // Header only: keep ID, opcode and RD, clear all section counts
+    packet[2] = 0x80 | (packet[2] & 0x79);
+    packet[3] = 0x80 | rcode;
+    memset(packet + 4, 0, 8);
+    _emptyCount++;
+    return DNS_HEADER_SIZE;
+}
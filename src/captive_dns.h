@@ -0,0 +1,56 @@
+#ifndef CAPTIVE_DNS_H
+#define CAPTIVE_DNS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ================================
+// CAPTIVE DNS RESPONDER
+// ================================
+
+// Answers every DNS query on the Access Point from its own FreeRTOS task, so
+// lookup throughput no longer depends on how often loop() runs. Each wakeup
+// drains all queued datagrams; A queries are answered with the portal address
+// from a prebuilt record, AAAA/HTTPS and other types get an empty NOERROR.
+class CaptiveDNS {
+public:
+    CaptiveDNS();
+    ~CaptiveDNS();
+
+    bool begin(const IPAddress& address, uint16_t port = DNS_PORT);
+    void end();
+    bool isRunning() const;
+
+    // Statistics
+    uint32_t getQueryCount() const;
+    uint32_t getAnswerCount() const;
+    uint32_t getEmptyCount() const;
+    uint32_t getDroppedCount() const;
+    uint32_t getBusyCycles() const;
+
+    // Rewrite a query in place into its response. Returns the response
+    // length, or 0 if the packet should be dropped. The buffer must have
+    // room for DNS_ANSWER_SIZE bytes past the end of the question.
+    size_t buildResponse(uint8_t* packet, size_t length, size_t capacity);
+
+private:
+    int _socket;
+    TaskHandle_t _task;
+    volatile bool _running;
+
+    // Prebuilt answer: name pointer, type A, class IN, TTL, address
+    uint8_t _answer[DNS_ANSWER_SIZE];
+
+    volatile uint32_t _queryCount;
+    volatile uint32_t _answerCount;
+    volatile uint32_t _emptyCount;
+    volatile uint32_t _droppedCount;
+    volatile uint32_t _busyCycles;      // Time spent handling packets
+
+    static void _taskEntry(void* parameter);
+    void _run();
+    void _buildAnswerTemplate(const IPAddress& address);
+    size_t _buildErrorResponse(uint8_t* packet, uint8_t rcode);
+};
+
+#endif // CAPTIVE_DNS_H
@@ -1,252 +1,344 @@
- #ifndef CONFIG_H
-#define CONFIG_H
-
-#include <Arduino.h>
-
-// ================================
-// DEVICE CONFIGURATION
-// ================================
-
-// Default Device Settings
-#define DEFAULT_DEVICE_NAME         "ESP32-Smart-Device"
-#define DEVICE_VERSION             "2.0.0"
-#define DEVICE_MANUFACTURER        "ESP32-IoT"
-#define FIRMWARE_BUILD_DATE        __DATE__ " " __TIME__
-
-// Device Name Constraints
-#define DEVICE_NAME_MIN_LENGTH     3
-#define DEVICE_NAME_MAX_LENGTH     32
-#define DEVICE_NAME_ALLOWED_CHARS  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
-
-// ================================
-// HARDWARE CONFIGURATION
-// ================================
-
-// Pin Definitions
-#define LED_PIN                    2      // Built-in LED
-#define BUTTON_PIN                 0      // Boot button (GPIO0)
-#define SENSOR_POWER_PIN          -1      // Optional sensor power control
-
-// Button Configuration
-#define BUTTON_DEBOUNCE_MS        50
-#define BUTTON_LONG_PRESS_MS      5000    // 5 seconds for WiFi reset
-#define BUTTON_VERY_LONG_PRESS_MS 10000   // 10 seconds for factory reset
-
-// LED Configuration
-#define LED_ACTIVE_HIGH           true
-#define LED_HEARTBEAT_INTERVAL    2000    // Heartbeat blink interval (ms)
-#define LED_HEARTBEAT_DURATION    100     // Heartbeat blink duration (ms)
-
-// ================================
-// WIFI CONFIGURATION
-// ================================
-
-// Access Point Settings
-#define AP_SSID_PREFIX            "ESP32-"
-#define AP_PASSWORD               "12345678"
-#define AP_CHANNEL                1
-#define AP_MAX_CONNECTIONS        4
-#define AP_HIDDEN                 false
-
-// Network Settings
-#define AP_IP_ADDRESS             IPAddress(192, 168, 4, 1)
-#define AP_GATEWAY                IPAddress(192, 168, 4, 1)
-#define AP_SUBNET                 IPAddress(255, 255, 255, 0)
-
-// WiFi Connection Settings
-#define WIFI_CONNECT_TIMEOUT_MS   20000   // 20 seconds
-#define WIFI_RECONNECT_INTERVAL   30000   // 30 seconds
-#define WIFI_MAX_RECONNECT_ATTEMPTS 5
-
-// Captive Portal Settings
-#define CAPTIVE_PORTAL_TIMEOUT    300000  // 5 minutes before auto-restart
-#define DNS_PORT                  53
-
-// ================================
-// WEB SERVER CONFIGURATION
-// ================================
-
-// Server Settings
-#define WEB_SERVER_PORT           80
-#define WEBSOCKET_PATH            "/ws"
-#define MAX_WEBSOCKET_CLIENTS     8
-
-// API Endpoints
-#define API_PREFIX                "/api"
-#define API_SCAN                  "/scan"
-#define API_CONNECT               "/connect"
-#define API_STATUS                "/status"
-#define API_SENSOR_DATA           "/sensor-data"
-#define API_DEVICE_STATS          "/stats"
-#define API_DEVICE_NAME           "/device-name"
-#define API_FACTORY_RESET         "/factory-reset"
-#define API_RESTART               "/restart"
-#define API_LED_CONTROL           "/led"
-
-// CORS Settings
-#define CORS_MAX_AGE              86400   // 24 hours
-
-// ================================
-// SENSOR CONFIGURATION
-// ================================
-
-// Sensor Update Intervals
-#define SENSOR_UPDATE_INTERVAL    2000    // 2 seconds
-#define SENSOR_HISTORY_SIZE       50      // Number of readings to store
-#define STATS_UPDATE_INTERVAL     10000   // 10 seconds
-
-// Sensor Simulation Settings
-#define TEMP_BASE                 22.0    // Base temperature (°C)
-#define TEMP_VARIATION            5.0     // Temperature variation range
-#define HUMIDITY_BASE             45.0    // Base humidity (%)
-#define HUMIDITY_VARIATION        20.0    // Humidity variation range
-#define PRESSURE_BASE             1013.25 // Base pressure (hPa)
-#define PRESSURE_VARIATION        30.0    // Pressure variation range
-
-// Battery Simulation
-#define BATTERY_DRAIN_RATE        0.01    // Battery drain per update (%)
-#define BATTERY_RECHARGE_THRESHOLD 10.0   // Auto-recharge below this level
-#define BATTERY_RECHARGE_RATE     5.0     // Recharge rate (%)
-
-// Motion Sensor Simulation
-#define MOTION_DETECTION_CHANCE   15      // 15% chance of motion detection
-#define MOTION_DURATION_MS        5000    // Motion stays active for 5 seconds
-
-// ================================
-// DATA STORAGE CONFIGURATION
-// ================================
-
-// Preferences Namespaces
-#define PREFS_NAMESPACE           "esp32_config"
-#define PREFS_WIFI_NAMESPACE      "wifi_config"
-#define PREFS_DEVICE_NAMESPACE    "device_config"
-
-// Preferences Keys
-#define PREF_DEVICE_NAME          "device_name"
-#define PREF_WIFI_SSID            "wifi_ssid"
-#define PREF_WIFI_PASSWORD        "wifi_password"
-#define PREF_TOTAL_CONNECTIONS    "total_conn"
-#define PREF_BOOT_COUNT           "boot_count"
-#define PREF_FACTORY_RESET_COUNT  "factory_count"
-
-// Data Retention
-#define PREFS_AUTO_COMMIT         true
-#define SENSOR_DATA_RETENTION_MS  3600000 // 1 hour
-
-// ================================
-// MDNS CONFIGURATION
-// ================================
-
-#define MDNS_SERVICE_NAME         "_http"
-#define MDNS_PROTOCOL             "_tcp"
-#define MDNS_SERVICE_PORT         80
-#define MDNS_TXT_VERSION          "version"
-#define MDNS_TXT_DEVICE           "device"
-
-// ================================
-// SYSTEM CONFIGURATION
-// ================================
-
-// Watchdog Settings
-#define WATCHDOG_TIMEOUT_MS       30000   // 30 seconds
-#define TASK_STACK_SIZE           4096
-#define LOOP_DELAY_MS             10
-
-// Memory Management
-#define MIN_FREE_HEAP             10000   // Minimum free heap (bytes)
-#define HEAP_CHECK_INTERVAL       30000   // Check heap every 30 seconds
-
-// System Limits
-#define MAX_JSON_BUFFER_SIZE      4096
-#define MAX_HTTP_RESPONSE_SIZE    8192
-#define MAX_WEBSOCKET_MESSAGE     1024
-
-// ================================
-// DEBUG CONFIGURATION
-// ================================
-
-// Debug Levels
-#define DEBUG_NONE                0
-#define DEBUG_ERROR               1
-#define DEBUG_WARN                2
-#define DEBUG_INFO                3
-#define DEBUG_DEBUG               4
-#define DEBUG_VERBOSE             5
-
-// Current Debug Level (change as needed)
-#ifndef DEBUG_LEVEL
-#define DEBUG_LEVEL               DEBUG_INFO
-#endif
-
-// Debug Macros
-#if DEBUG_LEVEL >= DEBUG_ERROR
-#define DEBUG_E(fmt, ...) Serial.printf("[ERROR] " fmt "\n", ##__VA_ARGS__)
-#else
-#define DEBUG_E(fmt, ...)
-#endif
-
-#if DEBUG_LEVEL >= DEBUG_WARN
-#define DEBUG_W(fmt, ...) Serial.printf("[WARN] " fmt "\n", ##__VA_ARGS__)
-#else
-#define DEBUG_W(fmt, ...)
-#endif
-
-#if DEBUG_LEVEL >= DEBUG_INFO
-#define DEBUG_I(fmt, ...) Serial.printf("[INFO] " fmt "\n", ##__VA_ARGS__)
-#else
-#define DEBUG_I(fmt, ...)
-#endif
-
-#if DEBUG_LEVEL >= DEBUG_DEBUG
-#define DEBUG_D(fmt, ...) Serial.printf("[DEBUG] " fmt "\n", ##__VA_ARGS__)
-#else
-#define DEBUG_D(fmt, ...)
-#endif
-
-#if DEBUG_LEVEL >= DEBUG_VERBOSE
-#define DEBUG_V(fmt, ...) Serial.printf("[VERBOSE] " fmt "\n", ##__VA_ARGS__)
-#else
-#define DEBUG_V(fmt, ...)
-#endif
-
-// ================================
-// FEATURE FLAGS
-// ================================
-
-// Enable/Disable Features
-#define FEATURE_WEBSOCKET         true
-#define FEATURE_MDNS              true
-#define FEATURE_OTA               false   // Disabled by default
-#define FEATURE_SENSOR_HISTORY    true
-#define FEATURE_DEVICE_STATS      true
-#define FEATURE_FACTORY_RESET     true
-#define FEATURE_LED_CONTROL       true
-#define FEATURE_BUTTON_CONTROL    true
-
-// Sensor Features
-#define SENSOR_TEMPERATURE        true
-#define SENSOR_HUMIDITY           true
-#define SENSOR_PRESSURE           true
-#define SENSOR_LIGHT              true
-#define SENSOR_MOTION             true
-#define SENSOR_BATTERY            true
-
-// ================================
-// VALIDATION MACROS
-// ================================
-
-// Compile-time checks
-#if DEVICE_NAME_MAX_LENGTH > 32
-#error "Device name maximum length cannot exceed 32 characters"
-#endif
-
-#if AP_MAX_CONNECTIONS > 8
-#error "ESP32 supports maximum 8 AP connections"
-#endif
-
-#if SENSOR_HISTORY_SIZE > 100
-#warning "Large sensor history size may cause memory issues"
-#endif
-
-#endif // CONFIG_H
-
+ #ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+
+// ================================
+// DEVICE CONFIGURATION
+// ================================
+
+// Default Device Settings
+#define DEFAULT_DEVICE_NAME         "ESP32-Smart-Device"
+#define DEVICE_VERSION             "2.0.0"
+#define DEVICE_MANUFACTURER        "ESP32-IoT"
+#define FIRMWARE_BUILD_DATE        __DATE__ " " __TIME__
+
+// Device Name Constraints
+#define DEVICE_NAME_MIN_LENGTH     3
+#define DEVICE_NAME_MAX_LENGTH     32
+#define WIFI_SSID_MAX_LENGTH       32      // 802.11 limit
+#define MAC_ADDRESS_LENGTH         18      // "AA:BB:CC:DD:EE:FF" and terminator
+#define DEVICE_NAME_ALLOWED_CHARS  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+
+// ================================
+// HARDWARE CONFIGURATION
+// ================================
+
+// Pin Definitions
+#define LED_PIN                    2      // Built-in LED
+#define BUTTON_PIN                 0      // Boot button (GPIO0)
+#define SENSOR_POWER_PIN          -1      // Optional sensor power control
+
+// Button Configuration
+#define BUTTON_DEBOUNCE_MS        50
+#define BUTTON_LONG_PRESS_MS      5000    // 5 seconds for WiFi reset
+#define BUTTON_VERY_LONG_PRESS_MS 10000   // 10 seconds for factory reset
+
+// LED Configuration
+#define LED_ACTIVE_HIGH           true
+#define LED_HEARTBEAT_INTERVAL    2000    // Heartbeat blink interval (ms)
+#define LED_HEARTBEAT_DURATION    100     // Heartbeat blink duration (ms)
+
+// ================================
+// WIFI CONFIGURATION
+// ================================
+
+// Access Point Settings
+#define AP_SSID_PREFIX            "ESP32-"
+#define AP_PASSWORD               "12345678"
+#define AP_CHANNEL                1
+#define AP_MAX_CONNECTIONS        4
+#define AP_HIDDEN                 false
+
+// Network Settings
+#define AP_IP_ADDRESS             IPAddress(192, 168, 4, 1)
+#define AP_GATEWAY                IPAddress(192, 168, 4, 1)
+#define AP_SUBNET                 IPAddress(255, 255, 255, 0)
+#define AP_PORTAL_URL             "http://192.168.4.1/"   // Must match AP_IP_ADDRESS
+
+// WiFi Connection Settings
+#define WIFI_CONNECT_TIMEOUT_MS   20000   // 20 seconds
+#define WIFI_RECONNECT_INTERVAL   30000   // 30 seconds
+#define WIFI_MAX_RECONNECT_ATTEMPTS 5
+#define WIFI_RECONNECT_SETTLE_MS  1000    // Between a reconnect's disconnect and its begin
+#define WIFI_AP_SHUTDOWN_DELAY_MS 15000   // Keep AP up after connecting so clients see the result
+
+// WiFi Scan Settings
+#define WIFI_SCAN_CACHE_TTL_MS    30000   // Serve cached scan results for 30 seconds
+#define WIFI_SCAN_TIMEOUT_MS      10000   // Give up on a background scan after 10 seconds
+#define WIFI_SCAN_ENTRY_MAX_AGE_MS 90000  // Drop networks not seen for 90 seconds
+#define WIFI_SCAN_MAX_RESULTS     32      // Keep the strongest 32 SSIDs
+
+// Captive Portal Settings
+#define CAPTIVE_PORTAL_TIMEOUT    300000  // 5 minutes before auto-restart
+#define DNS_PORT                  53
+
+// Captive DNS Responder
+#define DNS_TASK_STACK_SIZE       3072
+#define DNS_TASK_PRIORITY         2
+#define DNS_TASK_CORE             0       // Same core as the WiFi/lwIP stack
+#define DNS_RECV_TIMEOUT_MS       200     // Wakeup interval to notice shutdown
+#define DNS_MAX_PACKET_SIZE       512
+#define DNS_ANSWER_SIZE           16      // Compressed A record
+#define DNS_ANSWER_TTL            60      // Seconds
+
+// ================================
+// WEB SERVER CONFIGURATION
+// ================================
+
+// Server Settings
+#define WEB_SERVER_PORT           80
+#define WEBSOCKET_PATH            "/ws"
+#define MAX_WEBSOCKET_CLIENTS     8       // Oldest idle client is evicted beyond this
+#define WS_CLIENT_QUEUE_LIMIT     4       // Queued frames before a client counts as slow
+#define WS_EVICT_CLOSE_CODE       1013    // "Try again later"
+#define WS_MAX_TOPIC_INTERVAL_MS  3600000 // Slowest cadence a client can request
+#define WS_CHANGE_QUEUE_LENGTH    16      // Client changes waiting for the loop task
+
+// API Endpoints
+#define API_PREFIX                "/api"
+#define API_SCAN                  "/scan"
+#define API_CONNECT               "/connect"
+#define API_CONNECT_STATUS        "/connect/status"
+#define API_STATUS                "/status"
+#define API_SENSOR_DATA           "/sensor-data"
+#define API_SENSOR_HISTORY        "/sensor-history"
+#define API_DEVICE_STATS          "/stats"
+#define API_DEVICE_NAME           "/device-name"
+#define API_FACTORY_RESET         "/factory-reset"
+#define API_RESTART               "/restart"
+#define API_LED_CONTROL           "/led"
+#define API_EVENTS                "/events"
+#define API_METRICS               "/metrics"
+#define API_PROFILE               "/profile"
+
+// Server-Sent Events
+#define SSE_RETRY_MS              3000    // Reconnect delay suggested to clients
+
+// CORS Settings
+#define CORS_MAX_AGE              86400   // 24 hours
+
+// ================================
+// SENSOR CONFIGURATION
+// ================================
+
+// Sensor Update Intervals
+#define SENSOR_UPDATE_INTERVAL    2000    // 2 seconds
+#define SENSOR_HISTORY_SIZE       50      // Number of readings to store
+#define STATS_UPDATE_INTERVAL     10000   // 10 seconds
+
+// Sensor Simulation Settings
+#define TEMP_BASE                 22.0    // Base temperature (°C)
+#define TEMP_VARIATION            5.0     // Temperature variation range
+#define HUMIDITY_BASE             45.0    // Base humidity (%)
+#define HUMIDITY_VARIATION        20.0    // Humidity variation range
+#define PRESSURE_BASE             1013.25 // Base pressure (hPa)
+#define PRESSURE_VARIATION        30.0    // Pressure variation range
+
+// Battery Simulation
+#define BATTERY_DRAIN_RATE        0.01    // Battery drain per update (%)
+#define BATTERY_RECHARGE_THRESHOLD 10.0   // Auto-recharge below this level
+#define BATTERY_RECHARGE_RATE     5.0     // Recharge rate (%)
+
+// Motion Sensor Simulation
+#define MOTION_DETECTION_CHANCE   15      // 15% chance of motion detection
+#define MOTION_DURATION_MS        5000    // Motion stays active for 5 seconds
+
+// ================================
+// DATA STORAGE CONFIGURATION
+// ================================
+
+// Preferences Namespaces
+#define PREFS_NAMESPACE           "esp32_config"
+#define PREFS_WIFI_NAMESPACE      "wifi_config"
+#define PREFS_DEVICE_NAMESPACE    "device_config"
+
+// Preferences Keys
+#define PREF_DEVICE_NAME          "device_name"
+#define PREF_WIFI_SSID            "wifi_ssid"
+#define PREF_WIFI_PASSWORD        "wifi_password"
+#define PREF_TOTAL_CONNECTIONS    "total_conn"
+#define PREF_BOOT_COUNT           "boot_count"
+#define PREF_FACTORY_RESET_COUNT  "factory_count"
+
+// Data Retention
+#define PREFS_AUTO_COMMIT         true
+#define SENSOR_DATA_RETENTION_MS  3600000 // 1 hour
+
+// ================================
+// MDNS CONFIGURATION
+// ================================
+
+#define MDNS_SERVICE_NAME         "_http"
+#define MDNS_PROTOCOL             "_tcp"
+#define MDNS_SERVICE_PORT         80
+#define MDNS_TXT_VERSION          "version"
+#define MDNS_TXT_DEVICE           "device"
+
+// ================================
+// SYSTEM CONFIGURATION
+// ================================
+
+// Watchdog Settings
+#define WATCHDOG_TIMEOUT_MS       30000   // 30 seconds
+#define TASK_STACK_SIZE           4096
+
+// Scheduler (event-driven main loop)
+#define SCHEDULER_MAX_JOBS        16
+#define SCHEDULER_QUEUE_LENGTH    16      // Pending job triggers
+#define SCHEDULER_MAX_SLEEP_MS    1000    // Longest idle wait between passes
+#define WIFI_SERVICE_INTERVAL_MS  100     // Connection, scan and reconnect polling
+#define WEB_SERVICE_INTERVAL_MS   50      // WebSocket cleanup and deferred frames
+
+// Timer Wheel (scheduler deadlines)
+#define TIMER_WHEEL_TICK_MS       10      // Deadline resolution
+#define TIMER_WHEEL_BITS          6       // 64 slots per level, two levels cover ~41 s
+
+// CPU Monitor
+#define CPU_SAMPLE_INTERVAL_MS    1000    // Utilisation window
+#define CPU_IDLE_GAP_US           20      // Longer gaps between idle hook calls count as busy
+#define CPU_MAX_TASKS             24      // Tasks tracked per window
+
+// Block Pools (JSON scratch, reserved at boot)
+#define POOL_CLASS_COUNT          4
+#define POOL_BLOCK_SIZES          { 512, 1024, 2048, 4096 }
+#define POOL_BLOCK_COUNTS         { 6, 4, 2, 2 }  // ~19 KB in total
+
+// Async Logging (DEBUG_* output)
+#define LOG_BUFFER_SIZE           4096    // Pending lines; power of two
+#define LOG_MAX_RECORD_SIZE       192     // Format pointer plus one line's arguments
+#define LOG_LINE_LENGTH           256     // Longer formatted lines are cut
+#define LOG_DRAIN_INTERVAL_MS     20
+#define LOG_TASK_STACK_SIZE       3072
+#define LOG_TASK_PRIORITY         1       // Below async_tcp and the DNS task
+#define LOG_TASK_CORE             0
+
+// Memory Management
+#define MIN_FREE_HEAP             10000   // Minimum free heap (bytes)
+#define HEAP_CHECK_INTERVAL       30000   // Check heap every 30 seconds
+#define HEAP_CRITICAL_RESTART_MS  120000  // Restart only after this long in critical load
+
+// System Control (lets the HTTP response go out before the reboot)
+#define RESTART_DELAY_MS          1000
+#define FACTORY_RESET_DELAY_MS    3000
+
+// Admission Control (web server load shedding)
+#define ADMISSION_CHECK_INTERVAL_MS 500
+#define HEAP_CONSTRAINED_FREE     40000   // Below this: shed expensive routes and stats topics
+#define HEAP_CONSTRAINED_BLOCK    16384   // ...or when the largest free block is this small
+#define HEAP_CRITICAL_FREE        20000   // Below this: serve essential routes only
+#define HEAP_CRITICAL_BLOCK       8192
+#define HEAP_RECOVERY_MARGIN      4096    // Extra headroom needed before stepping down
+#define CONSTRAINED_MAX_CLIENTS   2       // Live connections accepted while constrained
+#define SHED_RETRY_AFTER_S        10
+
+// Metrics
+#define METRICS_LATENCY_BUCKETS   16      // 50 us .. 819 ms, plus +Inf
+#define METRICS_BUCKET_BASE_US    50
+#define PROFILER_REPORT_INTERVAL_MS 60000 // Loop profile dump to serial, 0 disables
+
+// System Limits
+#define MAX_JSON_BUFFER_SIZE      4096
+#define MAX_HTTP_RESPONSE_SIZE    8192
+#define MAX_WEBSOCKET_MESSAGE     1024
+
+// ================================
+// DEBUG CONFIGURATION
+// ================================
+
+// Debug Levels
+#define DEBUG_NONE                0
+#define DEBUG_ERROR               1
+#define DEBUG_WARN                2
+#define DEBUG_INFO                3
+#define DEBUG_DEBUG               4
+#define DEBUG_VERBOSE             5
+
+// Current Debug Level (change as needed)
+#ifndef DEBUG_LEVEL
+#define DEBUG_LEVEL               DEBUG_INFO
+#endif
+
+// Debug Macros
+#if DEBUG_LEVEL >= DEBUG_ERROR
+#define DEBUG_E(fmt, ...) DEBUG_OUTPUT("[ERROR] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_E(fmt, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_WARN
+#define DEBUG_W(fmt, ...) DEBUG_OUTPUT("[WARN] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_W(fmt, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_INFO
+#define DEBUG_I(fmt, ...) DEBUG_OUTPUT("[INFO] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_I(fmt, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_DEBUG
+#define DEBUG_D(fmt, ...) DEBUG_OUTPUT("[DEBUG] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_D(fmt, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_VERBOSE
+#define DEBUG_V(fmt, ...) DEBUG_OUTPUT("[VERBOSE] " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_V(fmt, ...)
+#endif
+
+// ================================
+// FEATURE FLAGS
+// ================================
+
+// Enable/Disable Features
+#define FEATURE_WEBSOCKET         true
+#define FEATURE_MDNS              true
+#define FEATURE_OTA               false   // Disabled by default
+#define FEATURE_SENSOR_HISTORY    true
+#define FEATURE_DEVICE_STATS      true
+#define FEATURE_FACTORY_RESET     true
+#define FEATURE_LED_CONTROL       true
+#define FEATURE_BUTTON_CONTROL    true
+#define FEATURE_PROFILER          true    // Loop stage timing (compiled out when false)
+#define FEATURE_CPU_IDLE_HOOK     false   // Per-core load from idle hooks; keeps both idle tasks spinning
+#define FEATURE_ASYNC_LOG         true    // DEBUG_* lines are formatted by a background task
+
+// Debug output backend
+#if FEATURE_ASYNC_LOG
+#include "async_log.h"
+#define DEBUG_OUTPUT logWrite
+#else
+#define DEBUG_OUTPUT Serial.printf
+#endif
+
+// Sensor Features
+#define SENSOR_TEMPERATURE        true
+#define SENSOR_HUMIDITY           true
+#define SENSOR_PRESSURE           true
+#define SENSOR_LIGHT              true
+#define SENSOR_MOTION             true
+#define SENSOR_BATTERY            true
+
+// ================================
+// VALIDATION MACROS
+// ================================
+
+// Compile-time checks
+#if DEVICE_NAME_MAX_LENGTH > 32
+#error "Device name maximum length cannot exceed 32 characters"
+#endif
+
+#if AP_MAX_CONNECTIONS > 8
+#error "ESP32 supports maximum 8 AP connections"
+#endif
+
+#if SENSOR_HISTORY_SIZE > 100
+#warning "Large sensor history size may cause memory issues"
+#endif
+
+#endif // CONFIG_H
+
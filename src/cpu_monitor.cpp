@@ -0,0 +1,224 @@
+#include "cpu_monitor.h"
+#include <esp_freertos_hooks.h>
+
+#define CPU_RUN_TIME_STATS (configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY)
+#define CPU_CORE_USAGE (FEATURE_CPU_IDLE_HOOK || CPU_RUN_TIME_STATS)
+
+CpuMonitor cpuMonitor;
+
+#if FEATURE_CPU_IDLE_HOOK
+// ================================
+// IDLE HOOKS
+// ================================
+
+// Written only by each core's own idle task
+static volatile uint32_t _idleCycles[portNUM_PROCESSORS];
+static uint32_t _idleStamp[portNUM_PROCESSORS];
+static uint32_t _idleGapCycles;
+
+// Returning false keeps the idle task looping instead of waiting for an
+// interrupt, so consecutive calls are only ever separated by preemption
+static bool IRAM_ATTR _idleHook() {
+    uint8_t core = xPortGetCoreID();
+    uint32_t now = ESP.getCycleCount();
+    uint32_t gap = now - _idleStamp[core];
+
+    if (gap < _idleGapCycles) {
+        _idleCycles[core] += gap;
+    }
+
+    _idleStamp[core] = now;
+    return false;
+}
+#endif
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+CpuMonitor::CpuMonitor() :
+    _lastSample(0),
+    _taskCount(0),
+    _counterCount(0),
+    _lastTaskCount(0),
+    _lastTotalRunTime(0)
+{
+    memset(_coreUsage, 0, sizeof(_coreUsage));
+    memset(_lastIdle, 0, sizeof(_lastIdle));
+}
+
+void CpuMonitor::begin() {
+    #if FEATURE_CPU_IDLE_HOOK
+    _idleGapCycles = CPU_IDLE_GAP_US * ESP.getCpuFreqMHz();
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        if (esp_register_freertos_idle_hook_for_cpu(_idleHook, core) != ESP_OK) {
+            DEBUG_W("Failed to register idle hook on core %u", core);
+        }
+    }
+    #endif
+
+    _lastSample = micros();
+    DEBUG_I("CPU monitor started (core load: %s, task accounting: %s)",
+            FEATURE_CPU_IDLE_HOOK ? "idle hook" : (CPU_RUN_TIME_STATS ? "run-time stats" : "off"),
+            CPU_RUN_TIME_STATS ? "run-time stats" : "instrumented");
+}
+
+void CpuMonitor::addTask(const char* name, CpuBusyCounter counter) {
+    if (_counterCount >= CPU_MAX_TASKS) {
+        return;
+    }
+
+    TaskCounter& task = _counters[_counterCount++];
+    task.name = name;
+    task.counter = counter;
+    task.last = counter();
+}
+
+// ================================
+// SAMPLING
+// ================================
+
+void CpuMonitor::sample() {
+    uint32_t now = micros();
+    uint32_t elapsedUs = now - _lastSample;
+
+    if (elapsedUs == 0) {
+        return;
+    }
+
+    _lastSample = now;
+    _sampleCores(elapsedUs);
+
+    #if CPU_RUN_TIME_STATS
+    _sampleRunTimeStats();
+    #else
+    _sampleCounters(elapsedUs);
+    #endif
+}
+
+// ================================
+// ACCESSORS
+// ================================
+
+uint8_t CpuMonitor::getCoreCount() const {
+    return portNUM_PROCESSORS;
+}
+
+float CpuMonitor::getCoreUsage(uint8_t core) const {
+    return core < portNUM_PROCESSORS ? _coreUsage[core] : 0.0;
+}
+
+float CpuMonitor::getTotalUsage() const {
+    float total = 0.0;
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        total += _coreUsage[core];
+    }
+
+    return total / portNUM_PROCESSORS;
+}
+
+uint8_t CpuMonitor::getTaskCount() const {
+    return _taskCount;
+}
+
+const CpuTaskUsage& CpuMonitor::getTask(uint8_t index) const {
+    return _tasks[index];
+}
+
+bool CpuMonitor::hasCoreUsage() const {
+    return CPU_CORE_USAGE;
+}
+
+bool CpuMonitor::hasRunTimeStats() const {
+    return CPU_RUN_TIME_STATS;
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void CpuMonitor::_sampleCores(uint32_t elapsedUs) {
+    #if FEATURE_CPU_IDLE_HOOK
+    float windowCycles = (float)elapsedUs * ESP.getCpuFreqMHz();
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t idle = _idleCycles[core];
+        float busy = 100.0 * (1.0 - (idle - _lastIdle[core]) / windowCycles);
+
+        _coreUsage[core] = constrain(busy, 0.0f, 100.0f);
+        _lastIdle[core] = idle;
+    }
+    #endif
+}
+
+void CpuMonitor::_sampleRunTimeStats() {
+    #if CPU_RUN_TIME_STATS
+    static TaskStatus_t status[CPU_MAX_TASKS];
+    uint32_t totalRunTime;
+    UBaseType_t count = uxTaskGetSystemState(status, CPU_MAX_TASKS, &totalRunTime);
+
+    // Zero means the table is too small for every task
+    if (count == 0) {
+        DEBUG_W("More than %d tasks, raise CPU_MAX_TASKS", CPU_MAX_TASKS);
+        return;
+    }
+
+    uint32_t window = totalRunTime - _lastTotalRunTime;
+    _taskCount = count;
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        CpuTaskUsage& task = _tasks[i];
+        strlcpy(task.name, status[i].pcTaskName, sizeof(task.name));
+        task.share = 0.0;
+
+        for (uint8_t j = 0; j < _lastTaskCount && window; j++) {
+            if (_lastTaskNumber[j] == status[i].xTaskNumber) {
+                task.share = 100.0 * (status[i].ulRunTimeCounter - _lastRunTime[j]) / window;
+                break;
+            }
+        }
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        _lastTaskNumber[i] = status[i].xTaskNumber;
+        _lastRunTime[i] = status[i].ulRunTimeCounter;
+    }
+
+    #if !FEATURE_CPU_IDLE_HOOK
+    // Each core is busy for whatever part of the window its idle task did not run
+    for (UBaseType_t i = 0; i < count; i++) {
+        for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+            if (status[i].xHandle != xTaskGetIdleTaskHandleForCPU(core)) {
+                continue;
+            }
+
+            uint32_t idle = status[i].ulRunTimeCounter;
+            if (window) {
+                float busy = 100.0 * (1.0 - (float)(idle - _lastIdle[core]) / window);
+                _coreUsage[core] = constrain(busy, 0.0f, 100.0f);
+            }
+            _lastIdle[core] = idle;
+        }
+    }
+    #endif
+
+    _lastTaskCount = count;
+    _lastTotalRunTime = totalRunTime;
+    #endif
+}
+
+void CpuMonitor::_sampleCounters(uint32_t elapsedUs) {
+    float windowCycles = (float)elapsedUs * ESP.getCpuFreqMHz();
+    _taskCount = _counterCount;
+
+    for (uint8_t i = 0; i < _counterCount; i++) {
+        TaskCounter& counter = _counters[i];
+        uint32_t busy = counter.counter();
+
+        strlcpy(_tasks[i].name, counter.name, sizeof(_tasks[i].name));
+        _tasks[i].share = constrain(100.0f * (busy - counter.last) / windowCycles, 0.0f, 100.0f);
+        counter.last = busy;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef CPU_MONITOR_H
+#define CPU_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ================================
+// CPU UTILISATION MONITOR
+// ================================
+
+// Cumulative busy cycles of a task we run ourselves; wraps freely
+typedef uint32_t (*CpuBusyCounter)();
+
+struct CpuTaskUsage {
+    char name[16];
+    float share;            // Percent of one core over the last window
+};
+
+// Per-core load comes from the idle tasks' FreeRTOS run-time stats when the
+// SDK is built with them. FEATURE_CPU_IDLE_HOOK measures it without them:
+// each core's idle task adds up the short gaps between its own hook calls,
+// but the hook keeps the idle tasks from ever sleeping the cores, so it is
+// off by default. Per-task shares also come from run-time stats; otherwise
+// only the tasks registered with addTask() are reported.
+class CpuMonitor {
+public:
+    CpuMonitor();
+
+    void begin();
+
+    // Fallback accounting for tasks whose busy time we measure ourselves
+    void addTask(const char* name, CpuBusyCounter counter);
+
+    // Close the current window (scheduled job)
+    void sample();
+
+    uint8_t getCoreCount() const;
+    float getCoreUsage(uint8_t core) const;
+    float getTotalUsage() const;
+
+    uint8_t getTaskCount() const;
+    const CpuTaskUsage& getTask(uint8_t index) const;
+    bool hasCoreUsage() const;
+    bool hasRunTimeStats() const;
+
+private:
+    struct TaskCounter {
+        const char* name;
+        CpuBusyCounter counter;
+        uint32_t last;
+    };
+
+    float _coreUsage[portNUM_PROCESSORS];
+    uint32_t _lastIdle[portNUM_PROCESSORS];     // Idle cycles or idle task run time
+    uint32_t _lastSample;
+
+    CpuTaskUsage _tasks[CPU_MAX_TASKS];
+    uint8_t _taskCount;
+
+    TaskCounter _counters[CPU_MAX_TASKS];
+    uint8_t _counterCount;
+
+    // Run-time stats from the previous window, matched by task number
+    UBaseType_t _lastTaskNumber[CPU_MAX_TASKS];
+    uint32_t _lastRunTime[CPU_MAX_TASKS];
+    uint8_t _lastTaskCount;
+    uint32_t _lastTotalRunTime;
+
+    void _sampleCores(uint32_t elapsedUs);
+    void _sampleRunTimeStats();
+    void _sampleCounters(uint32_t elapsedUs);
+};
+
+extern CpuMonitor cpuMonitor;
+
+#endif // CPU_MONITOR_H
@@ -0,0 +1,106 @@
+#include "heap_telemetry.h"
+#include <esp_heap_caps.h>
+
+const char* const HEAP_TAG_NAMES[HEAP_TAG_COUNT] = {
+    "wifi",
+    "web",
+    "sensors",
+    "json"
+};
+
+static HeapTagStats _tagStats[HEAP_TAG_COUNT];
+static portMUX_TYPE _tagLock = portMUX_INITIALIZER_UNLOCKED;
+
+// ================================
+// HEAP HEALTH
+// ================================
+
+HeapHealth getHeapHealth() {
+    HeapHealth health;
+    health.freeHeap = ESP.getFreeHeap();
+    health.largestBlock = ESP.getMaxAllocHeap();
+    health.minFreeHeap = ESP.getMinFreeHeap();
+    health.fragmentation = health.freeHeap ?
+        100.0 * (1.0 - (float)health.largestBlock / health.freeHeap) : 0.0;
+    return health;
+}
+
+// ================================
+// TAGGED ALLOCATIONS
+// ================================
+
+// Counters are updated under a spinlock; the allocation itself is not
+static void _account(HeapTag tag, size_t allocated, size_t freed, bool failed) {
+    portENTER_CRITICAL(&_tagLock);
+    HeapTagStats& stats = _tagStats[tag];
+
+    if (failed) {
+        stats.failures++;
+    }
+
+    if (allocated) {
+        stats.allocations++;
+        stats.bytesAllocated += allocated;
+        stats.bytesInUse += allocated;
+
+        if (stats.bytesInUse > stats.peakInUse) {
+            stats.peakInUse = stats.bytesInUse;
+        }
+    }
+
+    if (freed) {
+        stats.frees++;
+        stats.bytesInUse -= min((uint32_t)freed, stats.bytesInUse);
+    }
+
+    portEXIT_CRITICAL(&_tagLock);
+}
+
+void* heapAllocate(HeapTag tag, size_t size) {
+    void* ptr = malloc(size);
+    _account(tag, ptr ? heap_caps_get_allocated_size(ptr) : 0, 0, !ptr);
+    return ptr;
+}
+
+void* heapReallocate(HeapTag tag, void* ptr, size_t size) {
+    if (size == 0) {
+        heapRelease(tag, ptr);
+        return nullptr;
+    }
+
+    size_t before = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+    void* resized = realloc(ptr, size);
+
+    // On failure the old block stays live and stays accounted
+    if (!resized) {
+        _account(tag, 0, 0, true);
+        return nullptr;
+    }
+
+    _account(tag, heap_caps_get_allocated_size(resized), before, false);
+    return resized;
+}
+
+void heapRelease(HeapTag tag, void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    size_t size = heap_caps_get_allocated_size(ptr);
+    free(ptr);
+    _account(tag, 0, size, false);
+}
+
+void heapNote(HeapTag tag, size_t size) {
+    portENTER_CRITICAL(&_tagLock);
+    _tagStats[tag].allocations++;
+    _tagStats[tag].bytesAllocated += size;
+    portEXIT_CRITICAL(&_tagLock);
+}
+
+HeapTagStats getHeapTagStats(HeapTag tag) {
+    portENTER_CRITICAL(&_tagLock);
+    HeapTagStats stats = _tagStats[tag];
+    portEXIT_CRITICAL(&_tagLock);
+    return stats;
+}
@@ -0,0 +1,100 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <Arduino.h>
+#include <new>
+#include "config.h"
+
+// ================================
+// HEAP HEALTH
+// ================================
+
+struct HeapHealth {
+    size_t freeHeap;
+    size_t largestBlock;
+    size_t minFreeHeap;         // Low-water mark since boot
+    float fragmentation;        // Percent of free heap not in the largest block
+};
+
+HeapHealth getHeapHealth();
+
+// ================================
+// TAGGED ALLOCATIONS
+// ================================
+
+enum HeapTag : uint8_t {
+    HEAP_TAG_WIFI,
+    HEAP_TAG_WEB,
+    HEAP_TAG_SENSORS,
+    HEAP_TAG_JSON,
+    HEAP_TAG_COUNT
+};
+
+extern const char* const HEAP_TAG_NAMES[HEAP_TAG_COUNT];
+
+struct HeapTagStats {
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t failures;
+    uint32_t bytesAllocated;    // Cumulative
+    uint32_t bytesInUse;        // Wrapped allocations that are still live
+    uint32_t peakInUse;
+};
+
+// malloc/realloc/free that account the block to a subsystem; safe from
+// any task. Sizes are the real block sizes reported by the heap.
+void* heapAllocate(HeapTag tag, size_t size);
+void* heapReallocate(HeapTag tag, void* ptr, size_t size);
+void heapRelease(HeapTag tag, void* ptr);
+
+// Count an allocation made outside the wrappers (e.g. a String reserve);
+// it adds to the totals but is not tracked while live
+void heapNote(HeapTag tag, size_t size);
+
+HeapTagStats getHeapTagStats(HeapTag tag);
+
+// Standard container allocator charging to a tag
+template <typename T, HeapTag Tag>
+struct TaggedAllocator {
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef TaggedAllocator<U, Tag> other;
+    };
+
+    TaggedAllocator() {}
+
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+    T* allocate(size_t count) {
+        void* ptr = heapAllocate(Tag, count * sizeof(T));
+
+        if (!ptr) {
+#if __cpp_exceptions
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) {
+        heapRelease(Tag, ptr);
+    }
+};
+
+template <typename T, typename U, HeapTag Tag>
+bool operator==(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) {
+    return true;
+}
+
+template <typename T, typename U, HeapTag Tag>
+bool operator!=(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) {
+    return false;
+}
+
+#endif // HEAP_TELEMETRY_H
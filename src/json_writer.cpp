@@ -0,0 +1,293 @@
+#include "json_writer.h"
+
+// ================================
+// CONSTRUCTOR
+// ================================
+
+JsonWriter::JsonWriter(Print& out) :
+    _out(out),
+    _hasElements(0),
+    _depth(0),
+    _afterKey(false),
+    _written(0)
+{
+}
+
+// ================================
+// STRUCTURE
+// ================================
+
+JsonWriter& JsonWriter::beginObject() {
+    _beginValue();
+    _open('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginObject(const char* name) {
+    return key(name).beginObject();
+}
+
+JsonWriter& JsonWriter::endObject() {
+    _close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    _beginValue();
+    _open('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* name) {
+    return key(name).beginArray();
+}
+
+JsonWriter& JsonWriter::endArray() {
+    _close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    // Keys are compile-time literals and never need escaping
+    _beginValue();
+    _writeChar('"');
+    _writeRaw(name, strlen(name));
+    _writeRaw("\":", 2);
+    _afterKey = true;
+    return *this;
+}
+
+// ================================
+// VALUES
+// ================================
+
+JsonWriter& JsonWriter::value(int number) {
+    return value((long)number);
+}
+
+JsonWriter& JsonWriter::value(unsigned int number) {
+    return value((unsigned long)number);
+}
+
+JsonWriter& JsonWriter::value(long number) {
+    _beginValue();
+
+    if (number < 0) {
+        _writeChar('-');
+        _writeUnsigned(0UL - (unsigned long)number);
+    } else {
+        _writeUnsigned((unsigned long)number);
+    }
+
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long number) {
+    _beginValue();
+    _writeUnsigned(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    _beginValue();
+
+    if (flag) {
+        _writeRaw("true", 4);
+    } else {
+        _writeRaw("false", 5);
+    }
+
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(float number, uint8_t decimals) {
+    _beginValue();
+
+    if (isnan(number) || isinf(number)) {
+        _writeRaw("null", 4);
+        return *this;
+    }
+
+    char buffer[24];
+    int length = snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+    _writeRaw(buffer, length);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    _beginValue();
+
+    if (!text) {
+        _writeRaw("null", 4);
+        return *this;
+    }
+
+    _writeChar('"');
+    _writeEscaped(text, strlen(text));
+    _writeChar('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const String& text) {
+    _beginValue();
+    _writeChar('"');
+    _writeEscaped(text.c_str(), text.length());
+    _writeChar('"');
+    return *this;
+}
+
+// Embed an already serialised JSON fragment as a value
+JsonWriter& JsonWriter::rawValue(const char* json, size_t length) {
+    _beginValue();
+    _writeRaw(json, length);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* name, const IPAddress& address) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", address[0], address[1], address[2], address[3]);
+    return key(name).value(buffer);
+}
+
+size_t JsonWriter::bytesWritten() const {
+    return _written;
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void JsonWriter::_beginValue() {
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+
+    if (_depth == 0) {
+        return;
+    }
+
+    uint32_t bit = 1UL << (_depth - 1);
+
+    if (_hasElements & bit) {
+        _writeChar(',');
+    } else {
+        _hasElements |= bit;
+    }
+}
+
+void JsonWriter::_open(char bracket) {
+    _writeChar(bracket);
+
+    if (_depth < 32) {
+        _depth++;
+        _hasElements &= ~(1UL << (_depth - 1));
+    }
+}
+
+void JsonWriter::_close(char bracket) {
+    if (_depth > 0) {
+        _depth--;
+    }
+
+    _writeChar(bracket);
+}
+
+void JsonWriter::_writeUnsigned(unsigned long number) {
+    char buffer[20];
+    uint8_t pos = sizeof(buffer);
+
+    do {
+        buffer[--pos] = '0' + (number % 10);
+        number /= 10;
+    } while (number > 0);
+
+    _writeRaw(buffer + pos, sizeof(buffer) - pos);
+}
+
+void JsonWriter::_writeRaw(const char* data, size_t length) {
+    _written += _out.write((const uint8_t*)data, length);
+}
+
+void JsonWriter::_writeChar(char c) {
+    _written += _out.write((uint8_t)c);
+}
+
+void JsonWriter::_writeEscaped(const char* text, size_t length) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    size_t runStart = 0;
+
+    // Copy unescaped runs in one write; escape quotes, backslashes and control characters
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = (uint8_t)text[i];
+
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        _writeRaw(text + runStart, i - runStart);
+        runStart = i + 1;
+
+        switch (c) {
+            case '"':  _writeRaw("\\\"", 2); break;
+            case '\\': _writeRaw("\\\\", 2); break;
+            case '\n': _writeRaw("\\n", 2); break;
+            case '\r': _writeRaw("\\r", 2); break;
+            case '\t': _writeRaw("\\t", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F] };
+                _writeRaw(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+
+    _writeRaw(text + runStart, length - runStart);
+}
+
+// ================================
+// JSON BUFFER
+// ================================
+
+JsonBuffer::JsonBuffer(size_t capacity, HeapTag tag) : _capacity(0), _tag(tag) {
+    if (_buffer.reserve(capacity)) {
+        _capacity = capacity;
+        heapNote(tag, capacity);
+    }
+}
+
+size_t JsonBuffer::write(uint8_t c) {
+    return _ensure(1) && _buffer.concat((char)c) ? 1 : 0;
+}
+
+size_t JsonBuffer::write(const uint8_t* data, size_t length) {
+    return _ensure(length) && _buffer.concat((const char*)data, length) ? length : 0;
+}
+
+// String grows to the exact length it needs, so a document that outruns its
+// estimate would reallocate on every write; double the capacity instead
+bool JsonBuffer::_ensure(size_t extra) {
+    size_t needed = _buffer.length() + extra;
+
+    if (needed <= _capacity) {
+        return true;
+    }
+
+    size_t capacity = needed > 2 * _capacity ? needed : 2 * _capacity;
+
+    if (!_buffer.reserve(capacity)) {
+        return false;
+    }
+
+    heapNote(_tag, capacity);
+    _capacity = capacity;
+    return true;
+}
+
+size_t JsonBuffer::length() const {
+    return _buffer.length();
+}
+
+String JsonBuffer::release() {
+    return std::move(_buffer);
+}
@@ -0,0 +1,97 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+#include "heap_telemetry.h"
+
+// ================================
+// STREAMING JSON WRITER
+// ================================
+
+// Writes JSON straight to a Print target (response stream, buffer, Serial)
+// without building a document first. Commas are inserted automatically;
+// nesting is tracked in a bitmask, so depth is limited to 32 levels.
+class JsonWriter {
+public:
+    explicit JsonWriter(Print& out);
+
+    // Structure
+    JsonWriter& beginObject();
+    JsonWriter& beginObject(const char* key);
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& beginArray(const char* key);
+    JsonWriter& endArray();
+    JsonWriter& key(const char* key);
+
+    // Values (inside arrays or after key())
+    JsonWriter& value(int number);
+    JsonWriter& value(unsigned int number);
+    JsonWriter& value(long number);
+    JsonWriter& value(unsigned long number);
+    JsonWriter& value(bool flag);
+    JsonWriter& value(float number, uint8_t decimals);
+    JsonWriter& value(const char* text);
+    JsonWriter& value(const String& text);
+    JsonWriter& rawValue(const char* json, size_t length);
+
+    // Key/value shorthands
+    template <typename T>
+    JsonWriter& field(const char* name, T number) {
+        return key(name).value(number);
+    }
+    JsonWriter& field(const char* name, float number, uint8_t decimals) {
+        return key(name).value(number, decimals);
+    }
+    JsonWriter& field(const char* name, const char* text) {
+        return key(name).value(text);
+    }
+    JsonWriter& field(const char* name, const String& text) {
+        return key(name).value(text);
+    }
+    JsonWriter& field(const char* name, const IPAddress& address);
+
+    size_t bytesWritten() const;
+
+private:
+    Print& _out;
+    uint32_t _hasElements;  // Bit per depth: an element was already written
+    uint8_t _depth;
+    bool _afterKey;
+    size_t _written;
+
+    void _beginValue();
+    void _open(char bracket);
+    void _close(char bracket);
+    void _writeUnsigned(unsigned long number);
+    void _writeRaw(const char* data, size_t length);
+    void _writeChar(char c);
+    void _writeEscaped(const char* text, size_t length);
+};
+
+// ================================
+// PRE-SIZED STRING SINK
+// ================================
+
+// Print target that reserves its String once up front, so a JsonWriter
+// appending to it does not reallocate as long as the estimate holds.
+// The reservation is counted against the given heap tag.
+class JsonBuffer : public Print {
+public:
+    explicit JsonBuffer(size_t capacity, HeapTag tag = HEAP_TAG_JSON);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+
+    size_t length() const;
+    String release();
+
+private:
+    String _buffer;
+    size_t _capacity;
+    HeapTag _tag;
+
+    bool _ensure(size_t extra);
+};
+
+#endif // JSON_WRITER_H
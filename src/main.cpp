@@ -1,435 +1,589 @@
- /*
- * ESP32 Smart Captive Portal
- * Professional IoT Device with WiFi Management and Real-time Dashboard
- * 
- * Author: ESP32-IoT Project
- * Version: 2.0.0
- * License: MIT
- */
-
-#include <Arduino.h>
-#include <WiFi.h>
-#include <Preferences.h>
-#include <ESPmDNS.h>
-
-// Project Headers
-#include "config.h"
-#include "wifi_manager.h"
-#include "web_server.h"
-#include "sensor_manager.h"
-
-// ================================
-// GLOBAL VARIABLES
-// ================================
-
-// System State
-bool systemInitialized = false;
-unsigned long bootTime = 0;
-unsigned long lastHeartbeat = 0;
-unsigned long lastHeapCheck = 0;
-
-// Device Configuration
-String deviceName = DEFAULT_DEVICE_NAME;
-Preferences preferences;
-
-// Managers
-WiFiManager wifiManager;
-WebServerManager webServer;
-SensorManager sensorManager;
-
-// Hardware State
-bool ledState = false;
-bool buttonPressed = false;
-unsigned long buttonPressTime = 0;
-
-// Statistics
-uint32_t bootCount = 0;
-uint32_t totalConnections = 0;
-
-// ================================
-// FUNCTION DECLARATIONS
-// ================================
-
-void initializeSystem();
-void loadConfiguration();
-void saveConfiguration();
-void handleButton();
-void handleHeartbeat();
-void checkSystemHealth();
-void performFactoryReset();
-void restartDevice();
-String getSystemInfo();
-
-// ================================
-// SETUP FUNCTION
-// ================================
-
-void setup() {
-    // Initialize Serial Communication
-    Serial.begin(115200);
-    delay(1000);
-    
-    DEBUG_I("=================================");
-    DEBUG_I("ESP32 Smart Captive Portal v%s", DEVICE_VERSION);
-    DEBUG_I("Build: %s", FIRMWARE_BUILD_DATE);
-    DEBUG_I("=================================");
-    
-    // Record boot time
-    bootTime = millis();
-    
-    // Initialize system components
-    initializeSystem();
-    
-    DEBUG_I("System initialization complete");
-    DEBUG_I("Free heap: %d bytes", ESP.getFreeHeap());
-    DEBUG_I("Device ready!");
-}
-
-// ================================
-// MAIN LOOP
-// ================================
-
-void loop() {
-    // Handle WiFi management
-    wifiManager.handleClient();
-    
-    // Handle web server
-    webServer.handleClient();
-    
-    // Update sensor data
-    sensorManager.update();
-    
-    // Handle hardware inputs
-    handleButton();
-    
-    // System maintenance
-    handleHeartbeat();
-    checkSystemHealth();
-    
-    // Small delay to prevent watchdog issues
-    delay(LOOP_DELAY_MS);
-}
-
-// ================================
-// SYSTEM INITIALIZATION
-// ================================
-
-void initializeSystem() {
-    DEBUG_I("Initializing system components...");
-    
-    // Initialize hardware
-    pinMode(LED_PIN, OUTPUT);
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH); // LED off initially
-    
-    #if FEATURE_BUTTON_CONTROL
-    pinMode(BUTTON_PIN, INPUT_PULLUP);
-    #endif
-    
-    // Initialize preferences
-    preferences.begin(PREFS_NAMESPACE, false);
-    
-    // Load configuration
-    loadConfiguration();
-    
-    // Initialize managers
-    DEBUG_I("Initializing WiFi Manager...");
-    wifiManager.begin(deviceName);
-    
-    DEBUG_I("Initializing Web Server...");
-    webServer.begin();
-    
-    DEBUG_I("Initializing Sensor Manager...");
-    sensorManager.begin();
-    
-    // Setup mDNS
-    #if FEATURE_MDNS
-    String mdnsName = deviceName;
-    mdnsName.toLowerCase();
-    mdnsName.replace(" ", "-");
-    
-    if (MDNS.begin(mdnsName.c_str())) {
-        MDNS.addService(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_SERVICE_PORT);
-        MDNS.addServiceTxt(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_TXT_VERSION, DEVICE_VERSION);
-        MDNS.addServiceTxt(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_TXT_DEVICE, deviceName);
-        DEBUG_I("mDNS started: %s.local", mdnsName.c_str());
-    } else {
-        DEBUG_E("mDNS initialization failed");
-    }
-    #endif
-    
-    // Update boot statistics
-    bootCount++;
-    preferences.putUInt(PREF_BOOT_COUNT, bootCount);
-    
-    systemInitialized = true;
-    DEBUG_I("System initialization completed successfully");
-}
-
-// ================================
-// CONFIGURATION MANAGEMENT
-// ================================
-
-void loadConfiguration() {
-    DEBUG_I("Loading configuration from preferences...");
-    
-    // Load device name
-    deviceName = preferences.getString(PREF_DEVICE_NAME, DEFAULT_DEVICE_NAME);
-    
-    // Validate device name
-    if (deviceName.length() < DEVICE_NAME_MIN_LENGTH || 
-        deviceName.length() > DEVICE_NAME_MAX_LENGTH) {
-        DEBUG_W("Invalid device name length, using default");
-        deviceName = DEFAULT_DEVICE_NAME;
-    }
-    
-    // Load statistics
-    bootCount = preferences.getUInt(PREF_BOOT_COUNT, 0);
-    totalConnections = preferences.getUInt(PREF_TOTAL_CONNECTIONS, 0);
-    
-    DEBUG_I("Device name: %s", deviceName.c_str());
-    DEBUG_I("Boot count: %d", bootCount);
-    DEBUG_I("Total connections: %d", totalConnections);
-}
-
-void saveConfiguration() {
-    DEBUG_I("Saving configuration to preferences...");
-    
-    preferences.putString(PREF_DEVICE_NAME, deviceName);
-    preferences.putUInt(PREF_BOOT_COUNT, bootCount);
-    preferences.putUInt(PREF_TOTAL_CONNECTIONS, totalConnections);
-    
-    DEBUG_I("Configuration saved successfully");
-}
-
-// ================================
-// HARDWARE HANDLING
-// ================================
-
-void handleButton() {
-    #if FEATURE_BUTTON_CONTROL
-    static bool lastButtonState = HIGH;
-    static unsigned long buttonDebounceTime = 0;
-    
-    bool currentButtonState = digitalRead(BUTTON_PIN);
-    
-    // Debounce button
-    if (currentButtonState != lastButtonState) {
-        buttonDebounceTime = millis();
-    }
-    
-    if ((millis() - buttonDebounceTime) > BUTTON_DEBOUNCE_MS) {
-        if (currentButtonState == LOW && lastButtonState == HIGH) {
-            // Button pressed
-            buttonPressed = true;
-            buttonPressTime = millis();
-            DEBUG_D("Button pressed");
-        }
-        
-        if (currentButtonState == HIGH && lastButtonState == LOW) {
-            // Button released
-            if (buttonPressed) {
-                unsigned long pressDuration = millis() - buttonPressTime;
-                
-                if (pressDuration >= BUTTON_VERY_LONG_PRESS_MS) {
-                    // Very long press - Factory reset
-                    DEBUG_I("Very long button press detected - Factory reset");
-                    performFactoryReset();
-                } else if (pressDuration >= BUTTON_LONG_PRESS_MS) {
-                    // Long press - WiFi reset
-                    DEBUG_I("Long button press detected - WiFi reset");
-                    wifiManager.resetWiFiSettings();
-                    restartDevice();
-                } else {
-                    // Short press - Toggle LED
-                    DEBUG_D("Short button press - Toggle LED");
-                    ledState = !ledState;
-                    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
-                }
-                
-                buttonPressed = false;
-            }
-        }
-    }
-    
-    lastButtonState = currentButtonState;
-    #endif
-}
-
-void handleHeartbeat() {
-    unsigned long currentTime = millis();
-    
-    if (currentTime - lastHeartbeat >= LED_HEARTBEAT_INTERVAL) {
-        // Quick heartbeat blink
-        digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
-        delay(LED_HEARTBEAT_DURATION);
-        digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
-        
-        lastHeartbeat = currentTime;
-        
-        // Update mDNS
-        #if FEATURE_MDNS
-        MDNS.update();
-        #endif
-    }
-}
-
-// ================================
-// SYSTEM HEALTH MONITORING
-// ================================
-
-void checkSystemHealth() {
-    unsigned long currentTime = millis();
-    
-    if (currentTime - lastHeapCheck >= HEAP_CHECK_INTERVAL) {
-        size_t freeHeap = ESP.getFreeHeap();
-        
-        if (freeHeap < MIN_FREE_HEAP) {
-            DEBUG_W("Low memory warning: %d bytes free", freeHeap);
-            
-            // Attempt garbage collection
-            delay(100);
-            
-            // Check again
-            freeHeap = ESP.getFreeHeap();
-            if (freeHeap < MIN_FREE_HEAP / 2) {
-                DEBUG_E("Critical memory shortage - restarting");
-                restartDevice();
-            }
-        }
-        
-        lastHeapCheck = currentTime;
-        DEBUG_V("System health check - Free heap: %d bytes", freeHeap);
-    }
-}
-
-// ================================
-// SYSTEM CONTROL FUNCTIONS
-// ================================
-
-void performFactoryReset() {
-    DEBUG_I("Performing factory reset...");
-    
-    // Clear all preferences
-    preferences.clear();
-    
-    // Reset WiFi settings
-    wifiManager.resetWiFiSettings();
-    
-    // Update factory reset counter
-    uint32_t resetCount = preferences.getUInt(PREF_FACTORY_RESET_COUNT, 0) + 1;
-    preferences.putUInt(PREF_FACTORY_RESET_COUNT, resetCount);
-    
-    DEBUG_I("Factory reset completed. Reset count: %d", resetCount);
-    
-    // Restart device
-    delay(2000);
-    ESP.restart();
-}
-
-void restartDevice() {
-    DEBUG_I("Restarting device...");
-    
-    // Save current configuration
-    saveConfiguration();
-    
-    // Clean shutdown
-    webServer.end();
-    wifiManager.end();
-    
-    delay(1000);
-    ESP.restart();
-}
-
-// ================================
-// SYSTEM INFORMATION
-// ================================
-
-String getSystemInfo() {
-    String info = "{\n";
-    info += "  \"device_name\": \"" + deviceName + "\",\n";
-    info += "  \"version\": \"" + String(DEVICE_VERSION) + "\",\n";
-    info += "  \"build_date\": \"" + String(FIRMWARE_BUILD_DATE) + "\",\n";
-    info += "  \"uptime\": " + String(millis() - bootTime) + ",\n";
-    info += "  \"boot_count\": " + String(bootCount) + ",\n";
-    info += "  \"free_heap\": " + String(ESP.getFreeHeap()) + ",\n";
-    info += "  \"chip_model\": \"" + String(ESP.getChipModel()) + "\",\n";
-    info += "  \"chip_revision\": " + String(ESP.getChipRevision()) + ",\n";
-    info += "  \"cpu_freq\": " + String(ESP.getCpuFreqMHz()) + ",\n";
-    info += "  \"flash_size\": " + String(ESP.getFlashChipSize()) + ",\n";
-    info += "  \"mac_address\": \"" + WiFi.macAddress() + "\"\n";
-    info += "}";
-    
-    return info;
-}
-
-// ================================
-// CALLBACK FUNCTIONS FOR MANAGERS
-// ================================
-
-// Called when device name is changed
-void onDeviceNameChanged(const String& newName) {
-    if (newName.length() >= DEVICE_NAME_MIN_LENGTH && 
-        newName.length() <= DEVICE_NAME_MAX_LENGTH) {
-        
-        deviceName = newName;
-        saveConfiguration();
-        
-        DEBUG_I("Device name changed to: %s", deviceName.c_str());
-        
-        // Update mDNS
-        #if FEATURE_MDNS
-        MDNS.end();
-        String mdnsName = deviceName;
-        mdnsName.toLowerCase();
-        mdnsName.replace(" ", "-");
-        
-        if (MDNS.begin(mdnsName.c_str())) {
-            MDNS.addService(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_SERVICE_PORT);
-            DEBUG_I("mDNS updated: %s.local", mdnsName.c_str());
-        }
-        #endif
-    }
-}
-
-// Called when WiFi connection status changes
-void onWiFiStatusChanged(bool connected) {
-    if (connected) {
-        totalConnections++;
-        preferences.putUInt(PREF_TOTAL_CONNECTIONS, totalConnections);
-        DEBUG_I("WiFi connected. Total connections: %d", totalConnections);
-    } else {
-        DEBUG_I("WiFi disconnected");
-    }
-}
-
-// Called when LED state should be changed
-void onLEDControlRequest(bool state) {
-    ledState = state;
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
-    DEBUG_D("LED state changed to: %s", ledState ? "ON" : "OFF");
-}
-
-// ================================
-// GETTER FUNCTIONS FOR MANAGERS
-// ================================
-
-String getDeviceName() {
-    return deviceName;
-}
-
-uint32_t getBootCount() {
-    return bootCount;
-}
-
-uint32_t getTotalConnections() {
-    return totalConnections;
-}
-
-unsigned long getUptime() {
-    return millis() - bootTime;
-}
-
-bool getLEDState() {
-    return ledState;
-}
-
+ /*
+ * ESP32 Smart Captive Portal
+ * Professional IoT Device with WiFi Management and Real-time Dashboard
+ * 
+ * Author: ESP32-IoT Project
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <ESPmDNS.h>
+
+// Project Headers
+#include "config.h"
+#include "wifi_manager.h"
+#include "web_server.h"
+#include "sensor_manager.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "cpu_monitor.h"
+#include "heap_telemetry.h"
+#include "block_pool.h"
+
+// ================================
+// GLOBAL VARIABLES
+// ================================
+
+// System State
+bool systemInitialized = false;
+unsigned long bootTime = 0;
+
+// Device Configuration
+String deviceName = DEFAULT_DEVICE_NAME;
+Preferences preferences;
+
+// Managers
+WiFiManager wifiManager;
+WebServerManager webServer;
+SensorManager sensorManager;
+Scheduler scheduler;
+
+// Scheduler jobs triggered or deferred from callbacks and interrupts
+JobId wifiJob = INVALID_JOB;
+JobId heartbeatJob = INVALID_JOB;
+JobId buttonEdgeJob = INVALID_JOB;
+JobId buttonJob = INVALID_JOB;
+JobId profileResetJob = INVALID_JOB;
+JobId sensorsJob = INVALID_JOB;
+JobId restartJob = INVALID_JOB;
+JobId factoryResetJob = INVALID_JOB;
+unsigned long restartArmedAt = 0;
+unsigned long factoryResetArmedAt = 0;
+
+// Hardware State
+bool ledState = false;
+bool heartbeatOn = false;
+bool buttonPressed = false;
+unsigned long buttonPressTime = 0;
+
+// Statistics
+uint32_t bootCount = 0;
+uint32_t totalConnections = 0;
+
+// ================================
+// FUNCTION DECLARATIONS
+// ================================
+
+void initializeSystem();
+void loadConfiguration();
+void saveConfiguration();
+void setupScheduler();
+void handleButton();
+void handleButtonEdge();
+void IRAM_ATTR onButtonEdge();
+void onWiFiEvent(WiFiEvent_t event);
+void handleHeartbeat();
+void checkSystemHealth();
+bool deferSystemAction(JobId job, unsigned long& armedAt, unsigned long delayMs);
+void performFactoryReset();
+void restartDevice();
+String getSystemInfo();
+void connectManagers();
+
+// Manager callbacks and getters (defined below)
+void onDeviceNameChanged(const String& newName);
+void onLEDControlRequest(bool state);
+uint32_t getBootCount();
+uint32_t getTotalConnections();
+unsigned long getUptime();
+bool getLEDState();
+
+// ================================
+// SETUP FUNCTION
+// ================================
+
+void setup() {
+    // Initialize Serial Communication
+    Serial.begin(115200);
+    delay(1000);
+    
+    #if FEATURE_ASYNC_LOG
+    // Format debug output off the calling tasks from here on
+    logBegin();
+    #endif
+    
+    DEBUG_I("=================================");
+    DEBUG_I("ESP32 Smart Captive Portal v%s", DEVICE_VERSION);
+    DEBUG_I("Build: %s", FIRMWARE_BUILD_DATE);
+    DEBUG_I("=================================");
+    
+    // Record boot time
+    bootTime = millis();
+    
+    // Initialize system components
+    initializeSystem();
+    
+    DEBUG_I("System initialization complete");
+    DEBUG_I("Free heap: %d bytes", ESP.getFreeHeap());
+    DEBUG_I("Device ready!");
+}
+
+// ================================
+// MAIN LOOP
+// ================================
+
+void loop() {
+    // Sleeps until the next job is due or an event wakes it
+    scheduler.runOnce();
+}
+
+// ================================
+// SYSTEM INITIALIZATION
+// ================================
+
+void initializeSystem() {
+    DEBUG_I("Initializing system components...");
+    
+    // Initialize hardware
+    pinMode(LED_PIN, OUTPUT);
+    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH); // LED off initially
+    
+    #if FEATURE_BUTTON_CONTROL
+    pinMode(BUTTON_PIN, INPUT_PULLUP);
+    #endif
+    
+    // Reserve request scratch memory before the heap fragments
+    beginBlockPools();
+    
+    // Initialize preferences
+    preferences.begin(PREFS_NAMESPACE, false);
+    
+    // Load configuration
+    loadConfiguration();
+    
+    // Initialize managers
+    DEBUG_I("Initializing WiFi Manager...");
+    wifiManager.begin(deviceName);
+    
+    // Before the web server, which reads the sensor history
+    DEBUG_I("Initializing Sensor Manager...");
+    sensorManager.begin();
+    
+    DEBUG_I("Initializing Web Server...");
+    webServer.begin();
+    
+    DEBUG_I("Initializing CPU Monitor...");
+    cpuMonitor.begin();
+    
+    connectManagers();
+    setupScheduler();
+    
+    // Setup mDNS
+    #if FEATURE_MDNS
+    String mdnsName = deviceName;
+    mdnsName.toLowerCase();
+    mdnsName.replace(" ", "-");
+    
+    if (MDNS.begin(mdnsName.c_str())) {
+        MDNS.addService(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_SERVICE_PORT);
+        MDNS.addServiceTxt(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_TXT_VERSION, DEVICE_VERSION);
+        MDNS.addServiceTxt(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_TXT_DEVICE, deviceName);
+        DEBUG_I("mDNS started: %s.local", mdnsName.c_str());
+    } else {
+        DEBUG_E("mDNS initialization failed");
+    }
+    #endif
+    
+    // Update boot statistics
+    bootCount++;
+    preferences.putUInt(PREF_BOOT_COUNT, bootCount);
+    
+    systemInitialized = true;
+    DEBUG_I("System initialization completed successfully");
+}
+
+void connectManagers() {
+    // Give the web server access to the other managers
+    webServer.setWiFiManager(&wifiManager);
+    webServer.setSensorManager(&sensorManager);
+    
+    webServer.onDeviceNameChange(onDeviceNameChanged);
+    webServer.onLEDControl(onLEDControlRequest);
+    webServer.onFactoryReset([]() { scheduler.trigger(factoryResetJob); });
+    webServer.onRestart([]() { scheduler.trigger(restartJob); });
+    webServer.onProfileReset([]() { scheduler.trigger(profileResetJob); });
+    
+    // Requests made from web handlers are carried out by the WiFi job
+    wifiManager.onWorkPending([]() { scheduler.trigger(wifiJob); });
+    
+    // Push WiFi connection progress to dashboard clients
+    wifiManager.onConnectProgress([](const ConnectJob&) {
+        String message = "{\"type\":\"connect\",\"job\":" + wifiManager.getConnectJobJSON() + "}";
+        webServer.publish(TOPIC_WIFI, message);
+    });
+    
+    // Device statistics sources
+    sensorManager.setUptimeCallback(getUptime);
+    sensorManager.setBootCountCallback(getBootCount);
+    sensorManager.setTotalConnectionsCallback(getTotalConnections);
+    sensorManager.setWiFiInfoCallback(
+        []() { return wifiManager.getConnectedSSID(); },
+        []() { return wifiManager.getRSSI(); },
+        []() { return wifiManager.getMACAddress(); });
+    sensorManager.setLEDStateCallback(getLEDState);
+    sensorManager.setWebSocketClientsCallback([]() { return webServer.getWebSocketClientCount(); });
+    
+    // Busy time of the tasks we instrument ourselves
+    cpuMonitor.addTask("loopTask", []() { return scheduler.getBusyCycles(); });
+    cpuMonitor.addTask("async_tcp", []() { return webServer.getHandlerCycles(); });
+    cpuMonitor.addTask("captive_dns", []() { return wifiManager.getDNSBusyCycles(); });
+}
+
+void setupScheduler() {
+    scheduler.begin();
+    
+    // Periodic work
+    wifiJob = scheduler.addJob("wifi", []() { wifiManager.handleClient(); },
+                               WIFI_SERVICE_INTERVAL_MS, LOOP_STAGE_WIFI);
+    scheduler.addJob("web", []() { webServer.handleClient(); },
+                     WEB_SERVICE_INTERVAL_MS, LOOP_STAGE_WEB);
+    scheduler.addJob("load-level", []() { webServer.updateLoadLevel(); },
+                     ADMISSION_CHECK_INTERVAL_MS, LOOP_STAGE_LOAD_LEVEL);
+    sensorsJob = scheduler.addJob("sensors", []() { sensorManager.update(); },
+                                  sensorManager.getUpdateInterval(), LOOP_STAGE_SENSORS);
+    scheduler.addJob("sensor-stats", []() { sensorManager.updateStatistics(); },
+                     STATS_UPDATE_INTERVAL, LOOP_STAGE_SENSORS);
+    scheduler.addJob("broadcast-sensors", []() { webServer.broadcastSensorData(); },
+                     SENSOR_UPDATE_INTERVAL, LOOP_STAGE_BROADCAST);
+    scheduler.addJob("broadcast-stats", []() { webServer.broadcastDeviceStats(); },
+                     STATS_UPDATE_INTERVAL, LOOP_STAGE_BROADCAST);
+    heartbeatJob = scheduler.addJob("heartbeat", handleHeartbeat,
+                                    LED_HEARTBEAT_INTERVAL - LED_HEARTBEAT_DURATION, LOOP_STAGE_HEARTBEAT);
+    scheduler.addJob("health", checkSystemHealth, HEAP_CHECK_INTERVAL, LOOP_STAGE_HEALTH);
+    scheduler.addJob("cpu", []() { cpuMonitor.sample(); }, CPU_SAMPLE_INTERVAL_MS, LOOP_STAGE_CPU);
+    
+    // Histograms are only written on this task, so they are cleared here too
+    profileResetJob = scheduler.addJob("profile-reset", resetLoopProfile, 0, LOOP_STAGE_PROFILER);
+    
+    // Restarts run on this task, never inside the web handler that asked for them
+    restartJob = scheduler.addJob("restart", restartDevice, 0, LOOP_STAGE_HEALTH);
+    factoryResetJob = scheduler.addJob("factory-reset", performFactoryReset, 0, LOOP_STAGE_HEALTH);
+    
+    #if FEATURE_PROFILER && PROFILER_REPORT_INTERVAL_MS > 0
+    scheduler.addJob("profile-report", []() { printLoopProfile(Serial); },
+                     PROFILER_REPORT_INTERVAL_MS, LOOP_STAGE_PROFILER);
+    #endif
+    
+    // WiFi events wake the WiFi job instead of waiting for its next poll
+    WiFi.onEvent(onWiFiEvent);
+    
+    // A new sensor interval re-arms the sensor job straight away
+    sensorManager.setUpdateIntervalCallback([](unsigned long interval) {
+        scheduler.setInterval(sensorsJob, interval);
+    });
+    
+    // Button edges are debounced by deferring the sampling job
+    #if FEATURE_BUTTON_CONTROL
+    buttonEdgeJob = scheduler.addJob("button-edge", handleButtonEdge, 0, LOOP_STAGE_BUTTON);
+    buttonJob = scheduler.addJob("button", handleButton, 0, LOOP_STAGE_BUTTON);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonEdge, CHANGE);
+    #endif
+}
+
+void onWiFiEvent(WiFiEvent_t event) {
+    scheduler.trigger(wifiJob);
+}
+
+// ================================
+// CONFIGURATION MANAGEMENT
+// ================================
+
+void loadConfiguration() {
+    DEBUG_I("Loading configuration from preferences...");
+    
+    // Load device name
+    deviceName = preferences.getString(PREF_DEVICE_NAME, DEFAULT_DEVICE_NAME);
+    
+    // Validate device name
+    if (deviceName.length() < DEVICE_NAME_MIN_LENGTH || 
+        deviceName.length() > DEVICE_NAME_MAX_LENGTH) {
+        DEBUG_W("Invalid device name length, using default");
+        deviceName = DEFAULT_DEVICE_NAME;
+    }
+    
+    // Load statistics
+    bootCount = preferences.getUInt(PREF_BOOT_COUNT, 0);
+    totalConnections = preferences.getUInt(PREF_TOTAL_CONNECTIONS, 0);
+    
+    DEBUG_I("Device name: %s", deviceName.c_str());
+    DEBUG_I("Boot count: %d", bootCount);
+    DEBUG_I("Total connections: %d", totalConnections);
+}
+
+void saveConfiguration() {
+    DEBUG_I("Saving configuration to preferences...");
+    
+    preferences.putString(PREF_DEVICE_NAME, deviceName);
+    preferences.putUInt(PREF_BOOT_COUNT, bootCount);
+    preferences.putUInt(PREF_TOTAL_CONNECTIONS, totalConnections);
+    
+    DEBUG_I("Configuration saved successfully");
+}
+
+// ================================
+// HARDWARE HANDLING
+// ================================
+
+void IRAM_ATTR onButtonEdge() {
+    scheduler.triggerFromISR(buttonEdgeJob);
+}
+
+// Every edge pushes the sample point out; bounces keep postponing it
+void handleButtonEdge() {
+    scheduler.defer(buttonJob, BUTTON_DEBOUNCE_MS);
+}
+
+// Runs once the pin has been stable for BUTTON_DEBOUNCE_MS
+void handleButton() {
+    #if FEATURE_BUTTON_CONTROL
+    static bool lastButtonState = HIGH;
+    
+    bool currentButtonState = digitalRead(BUTTON_PIN);
+    
+    if (currentButtonState == lastButtonState) {
+        return;
+    }
+    
+    lastButtonState = currentButtonState;
+    
+    if (currentButtonState == LOW) {
+        // Button pressed
+        buttonPressed = true;
+        buttonPressTime = millis();
+        DEBUG_D("Button pressed");
+        return;
+    }
+    
+    // Button released
+    if (buttonPressed) {
+        unsigned long pressDuration = millis() - buttonPressTime;
+        
+        if (pressDuration >= BUTTON_VERY_LONG_PRESS_MS) {
+            // Very long press - Factory reset
+            DEBUG_I("Very long button press detected - Factory reset");
+            scheduler.trigger(factoryResetJob);
+        } else if (pressDuration >= BUTTON_LONG_PRESS_MS) {
+            // Long press - WiFi reset
+            DEBUG_I("Long button press detected - WiFi reset");
+            wifiManager.resetWiFiSettings();
+            scheduler.trigger(restartJob);
+        } else {
+            // Short press - Toggle LED
+            DEBUG_D("Short button press - Toggle LED");
+            ledState = !ledState;
+            digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
+        }
+        
+        buttonPressed = false;
+    }
+    #endif
+}
+
+// Alternates between a short blink and the rest of the interval without blocking
+void handleHeartbeat() {
+    if (!heartbeatOn) {
+        digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
+        heartbeatOn = true;
+        
+        // Turn the LED back off after the blink
+        scheduler.defer(heartbeatJob, LED_HEARTBEAT_DURATION);
+        return;
+    }
+    
+    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
+    heartbeatOn = false;
+    
+    // Update mDNS
+    #if FEATURE_MDNS
+    MDNS.update();
+    #endif
+}
+
+// ================================
+// SYSTEM HEALTH MONITORING
+// ================================
+
+void checkSystemHealth() {
+    size_t freeHeap = ESP.getFreeHeap();
+    
+    if (freeHeap < MIN_FREE_HEAP) {
+        DEBUG_W("Low memory warning: %d bytes free", freeHeap);
+        
+        String alert = "{\"type\":\"alert\",\"level\":\"warning\",\"message\":\"Low memory\",\"free_heap\":" + String(freeHeap) + "}";
+        webServer.publish(TOPIC_ALERTS, alert);
+        
+        // The web server sheds load first; restart only if that has not helped
+        if (freeHeap < MIN_FREE_HEAP / 2 &&
+            webServer.getLoadLevel() == LoadLevel::CRITICAL &&
+            webServer.getLoadLevelDuration() >= HEAP_CRITICAL_RESTART_MS) {
+            DEBUG_E("Critical memory shortage persisted - restarting");
+            scheduler.trigger(restartJob);
+        }
+    }
+    
+    HeapHealth health = getHeapHealth();
+    DEBUG_V("System health check - Free heap: %d bytes, largest block %d, min %d, fragmentation %.1f%%",
+            health.freeHeap, health.largestBlock, health.minFreeHeap, health.fragmentation);
+}
+
+// ================================
+// SYSTEM CONTROL FUNCTIONS
+// ================================
+
+// The first run of a restart job only arms its deadline, so a pending HTTP
+// response is sent first; early re-triggers keep the original deadline
+bool deferSystemAction(JobId job, unsigned long& armedAt, unsigned long delayMs) {
+    unsigned long now = millis();
+    
+    if (armedAt == 0) {
+        armedAt = now | 1;
+        scheduler.defer(job, delayMs);
+        return true;
+    }
+    
+    unsigned long elapsed = now - armedAt;
+    if (elapsed < delayMs) {
+        scheduler.defer(job, delayMs - elapsed);
+        return true;
+    }
+    
+    return false;
+}
+
+void performFactoryReset() {
+    if (deferSystemAction(factoryResetJob, factoryResetArmedAt, FACTORY_RESET_DELAY_MS)) {
+        DEBUG_I("Factory reset in %d ms", FACTORY_RESET_DELAY_MS);
+        return;
+    }
+    
+    DEBUG_I("Performing factory reset...");
+    
+    // Clear all preferences
+    preferences.clear();
+    
+    // Reset WiFi settings
+    wifiManager.resetWiFiSettings();
+    
+    // Update factory reset counter
+    uint32_t resetCount = preferences.getUInt(PREF_FACTORY_RESET_COUNT, 0) + 1;
+    preferences.putUInt(PREF_FACTORY_RESET_COUNT, resetCount);
+    
+    DEBUG_I("Factory reset completed. Reset count: %d", resetCount);
+    
+    ESP.restart();
+}
+
+void restartDevice() {
+    if (deferSystemAction(restartJob, restartArmedAt, RESTART_DELAY_MS)) {
+        DEBUG_I("Restart in %d ms", RESTART_DELAY_MS);
+        return;
+    }
+    
+    DEBUG_I("Restarting device...");
+    
+    // Save current configuration
+    saveConfiguration();
+    
+    // Clean shutdown
+    webServer.end();
+    wifiManager.end();
+    
+    ESP.restart();
+}
+
+// ================================
+// SYSTEM INFORMATION
+// ================================
+
+String getSystemInfo() {
+    String info = "{\n";
+    info += "  \"device_name\": \"" + deviceName + "\",\n";
+    info += "  \"version\": \"" + String(DEVICE_VERSION) + "\",\n";
+    info += "  \"build_date\": \"" + String(FIRMWARE_BUILD_DATE) + "\",\n";
+    info += "  \"uptime\": " + String(millis() - bootTime) + ",\n";
+    info += "  \"boot_count\": " + String(bootCount) + ",\n";
+    info += "  \"free_heap\": " + String(ESP.getFreeHeap()) + ",\n";
+    info += "  \"chip_model\": \"" + String(ESP.getChipModel()) + "\",\n";
+    info += "  \"chip_revision\": " + String(ESP.getChipRevision()) + ",\n";
+    info += "  \"cpu_freq\": " + String(ESP.getCpuFreqMHz()) + ",\n";
+    info += "  \"flash_size\": " + String(ESP.getFlashChipSize()) + ",\n";
+    info += "  \"mac_address\": \"" + String(wifiManager.getMACAddress()) + "\"\n";
+    info += "}";
+    
+    return info;
+}
+
+// ================================
+// CALLBACK FUNCTIONS FOR MANAGERS
+// ================================
+
+// Called when device name is changed
+void onDeviceNameChanged(const String& newName) {
+    if (newName.length() >= DEVICE_NAME_MIN_LENGTH && 
+        newName.length() <= DEVICE_NAME_MAX_LENGTH) {
+        
+        deviceName = newName;
+        saveConfiguration();
+        
+        DEBUG_I("Device name changed to: %s", deviceName.c_str());
+        
+        // Update mDNS
+        #if FEATURE_MDNS
+        MDNS.end();
+        String mdnsName = deviceName;
+        mdnsName.toLowerCase();
+        mdnsName.replace(" ", "-");
+        
+        if (MDNS.begin(mdnsName.c_str())) {
+            MDNS.addService(MDNS_SERVICE_NAME, MDNS_PROTOCOL, MDNS_SERVICE_PORT);
+            DEBUG_I("mDNS updated: %s.local", mdnsName.c_str());
+        }
+        #endif
+    }
+}
+
+// Called when WiFi connection status changes
+void onWiFiStatusChanged(bool connected) {
+    if (connected) {
+        totalConnections++;
+        preferences.putUInt(PREF_TOTAL_CONNECTIONS, totalConnections);
+        DEBUG_I("WiFi connected. Total connections: %d", totalConnections);
+    } else {
+        DEBUG_I("WiFi disconnected");
+    }
+}
+
+// Called when LED state should be changed
+void onLEDControlRequest(bool state) {
+    ledState = state;
+    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? ledState : !ledState);
+    DEBUG_D("LED state changed to: %s", ledState ? "ON" : "OFF");
+}
+
+// ================================
+// GETTER FUNCTIONS FOR MANAGERS
+// ================================
+
+String getDeviceName() {
+    return deviceName;
+}
+
+uint32_t getBootCount() {
+    return bootCount;
+}
+
+uint32_t getTotalConnections() {
+    return totalConnections;
+}
+
+unsigned long getUptime() {
+    return millis() - bootTime;
+}
+
+bool getLEDState() {
+    return ledState;
+}
+
@@ -0,0 +1,204 @@
+#include "metrics.h"
+
+LatencyHistogram loopStageMetrics[LOOP_STAGE_COUNT];
+
+const char* const LOOP_STAGE_NAMES[LOOP_STAGE_COUNT] = {
+    "wifi",
+    "web",
+    "broadcast",
+    "sensors",
+    "button",
+    "heartbeat",
+    "health",
+    "load_level",
+    "cpu",
+    "profiler"
+};
+
+// Cycles in one base bucket width; the CPU clock is fixed after boot
+static uint32_t _bucketBaseCycles() {
+    static uint32_t baseCycles = METRICS_BUCKET_BASE_US * ESP.getCpuFreqMHz();
+    return baseCycles;
+}
+
+// ================================
+// LATENCY HISTOGRAM
+// ================================
+
+void LatencyHistogram::record(uint32_t cycles) {
+    uint32_t scaled = cycles / _bucketBaseCycles();
+    uint8_t bucket = scaled ? 32 - __builtin_clz(scaled) : 0;
+
+    if (bucket >= METRICS_LATENCY_BUCKETS) {
+        bucket = METRICS_LATENCY_BUCKETS - 1;
+    }
+
+    if (count == 0 || cycles < minCycles) {
+        minCycles = cycles;
+    }
+
+    if (cycles > maxCycles) {
+        maxCycles = cycles;
+    }
+
+    buckets[bucket]++;
+    count++;
+    sumCycles += cycles;
+}
+
+void LatencyHistogram::reset() {
+    memset(this, 0, sizeof(*this));
+}
+
+// ================================
+// LOOP PROFILE
+// ================================
+
+void writeLoopProfileJSON(JsonWriter& json) {
+    uint32_t mhz = ESP.getCpuFreqMHz();
+
+    json.beginObject();
+    json.field("enabled", (bool)FEATURE_PROFILER);
+    json.field("bucket_base_us", (unsigned long)METRICS_BUCKET_BASE_US);
+    json.beginArray("stages");
+
+    for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+        const LatencyHistogram& histogram = loopStageMetrics[stage];
+
+        json.beginObject();
+        json.field("name", LOOP_STAGE_NAMES[stage]);
+        json.field("count", (unsigned long)histogram.count);
+        json.field("min_us", (unsigned long)(histogram.minCycles / mhz));
+        json.field("avg_us", (unsigned long)(histogram.count ? histogram.sumCycles / histogram.count / mhz : 0));
+        json.field("max_us", (unsigned long)(histogram.maxCycles / mhz));
+        json.field("total_ms", (unsigned long)(histogram.sumCycles / mhz / 1000));
+
+        // Bucket i counts samples under bucket_base_us << i, the last is overflow
+        json.beginArray("buckets");
+        for (uint8_t i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+            json.value((unsigned long)histogram.buckets[i]);
+        }
+        json.endArray();
+
+        json.endObject();
+    }
+
+    json.endArray();
+    json.endObject();
+}
+
+void printLoopProfile(Print& out) {
+    uint32_t mhz = ESP.getCpuFreqMHz();
+
+    out.println("Loop profile (us)    count      min      avg      max");
+
+    for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+        const LatencyHistogram& histogram = loopStageMetrics[stage];
+        unsigned long average = histogram.count ? histogram.sumCycles / histogram.count / mhz : 0;
+
+        out.printf("  %-12s %10lu %8lu %8lu %8lu\n", LOOP_STAGE_NAMES[stage], (unsigned long)histogram.count,
+                   (unsigned long)(histogram.minCycles / mhz), average, (unsigned long)(histogram.maxCycles / mhz));
+
+        // Non-empty buckets as "<limit_us:count"
+        bool any = false;
+        for (uint8_t i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+            if (histogram.buckets[i] == 0) {
+                continue;
+            }
+            if (i == METRICS_LATENCY_BUCKETS - 1) {
+                out.printf("%s>=%lu:%lu", any ? " " : "    ", (unsigned long)METRICS_BUCKET_BASE_US << (i - 1),
+                           (unsigned long)histogram.buckets[i]);
+            } else {
+                out.printf("%s<%lu:%lu", any ? " " : "    ", (unsigned long)METRICS_BUCKET_BASE_US << i,
+                           (unsigned long)histogram.buckets[i]);
+            }
+            any = true;
+        }
+
+        if (any) {
+            out.println();
+        }
+    }
+}
+
+void resetLoopProfile() {
+    for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+        loopStageMetrics[stage].reset();
+    }
+}
+
+// ================================
+// PROMETHEUS WRITER
+// ================================
+
+PrometheusWriter::PrometheusWriter(Print& out) :
+    _out(out),
+    _written(0)
+{
+}
+
+void PrometheusWriter::family(const char* name, const char* type, const char* help) {
+    _written += _out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void PrometheusWriter::sample(const char* name, const char* labels, unsigned long value) {
+    _series(name, "", labels, nullptr);
+    _written += _out.printf(" %lu\n", value);
+}
+
+void PrometheusWriter::sample(const char* name, const char* labels, double value) {
+    _series(name, "", labels, nullptr);
+    _written += _out.printf(" %.6f\n", value);
+}
+
+void PrometheusWriter::histogram(const char* name, const char* labels, const LatencyHistogram& histogram) {
+    double cyclesPerSecond = ESP.getCpuFreqMHz() * 1000000.0;
+    unsigned long cumulative = 0;
+    char le[24];
+
+    // Buckets are cumulative in the exposition format
+    for (uint8_t i = 0; i < METRICS_LATENCY_BUCKETS - 1; i++) {
+        cumulative += histogram.buckets[i];
+        snprintf(le, sizeof(le), "le=\"%g\"", (METRICS_BUCKET_BASE_US << i) / 1000000.0);
+        _series(name, "_bucket", labels, le);
+        _written += _out.printf(" %lu\n", cumulative);
+    }
+
+    _series(name, "_bucket", labels, "le=\"+Inf\"");
+    _written += _out.printf(" %lu\n", (unsigned long)histogram.count);
+
+    _series(name, "_sum", labels, nullptr);
+    _written += _out.printf(" %.6f\n", histogram.sumCycles / cyclesPerSecond);
+
+    _series(name, "_count", labels, nullptr);
+    _written += _out.printf(" %lu\n", (unsigned long)histogram.count);
+}
+
+size_t PrometheusWriter::bytesWritten() const {
+    return _written;
+}
+
+void PrometheusWriter::_series(const char* name, const char* suffix, const char* labels, const char* extraLabel) {
+    _written += _out.print(name);
+    _written += _out.print(suffix);
+
+    if (!labels && !extraLabel) {
+        return;
+    }
+
+    _written += _out.print('{');
+
+    if (labels) {
+        _written += _out.print(labels);
+    }
+
+    if (labels && extraLabel) {
+        _written += _out.print(',');
+    }
+
+    if (extraLabel) {
+        _written += _out.print(extraLabel);
+    }
+
+    _written += _out.print('}');
+}
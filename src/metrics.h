@@ -0,0 +1,119 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "json_writer.h"
+
+// ================================
+// LATENCY HISTOGRAM
+// ================================
+
+// Log2 buckets over CPU cycles: bucket i counts samples shorter than
+// METRICS_BUCKET_BASE_US << i, the last bucket is the +Inf overflow.
+// Every histogram has a single writer task, so recording is a few plain
+// increments and one divide; readers tolerate a torn sample.
+struct LatencyHistogram {
+    uint32_t buckets[METRICS_LATENCY_BUCKETS];
+    uint32_t count;
+    uint64_t sumCycles;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+
+    void record(uint32_t cycles);
+    void reset();
+};
+
+// Request counters for one route
+struct RouteMetrics {
+    LatencyHistogram latency;
+    uint32_t statusClass[5];   // 1xx .. 5xx
+    uint32_t bytesSent;
+    uint32_t shed;             // Refused by admission control
+};
+
+// ================================
+// LOOP STAGE TIMING
+// ================================
+
+enum LoopStage : uint8_t {
+    LOOP_STAGE_WIFI,
+    LOOP_STAGE_WEB,
+    LOOP_STAGE_BROADCAST,
+    LOOP_STAGE_SENSORS,
+    LOOP_STAGE_BUTTON,
+    LOOP_STAGE_HEARTBEAT,
+    LOOP_STAGE_HEALTH,
+    LOOP_STAGE_LOAD_LEVEL,
+    LOOP_STAGE_CPU,
+    LOOP_STAGE_PROFILER,
+    LOOP_STAGE_COUNT
+};
+
+extern LatencyHistogram loopStageMetrics[LOOP_STAGE_COUNT];
+extern const char* const LOOP_STAGE_NAMES[LOOP_STAGE_COUNT];
+
+// Cycle counter timestamp; differences are valid for ~17 s at 240 MHz
+inline uint32_t metricsTimestamp() {
+    return ESP.getCycleCount();
+}
+
+// Records the lifetime of a scope into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& histogram) :
+        _histogram(histogram),
+        _start(metricsTimestamp())
+    {
+    }
+
+    ~ScopedTimer() {
+        _histogram.record(metricsTimestamp() - _start);
+    }
+
+private:
+    LatencyHistogram& _histogram;
+    uint32_t _start;
+};
+
+// PROFILE_SCOPE(loopStageMetrics[LOOP_STAGE_WEB]) times the enclosing
+// block; with FEATURE_PROFILER off it expands to nothing
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if FEATURE_PROFILER
+#define PROFILE_SCOPE(histogram) ScopedTimer PROFILE_CONCAT(_profileScope, __LINE__)(histogram)
+#else
+#define PROFILE_SCOPE(histogram)
+#endif
+
+// Loop profile report: per-stage count, min/avg/max and histogram
+void writeLoopProfileJSON(JsonWriter& json);
+void printLoopProfile(Print& out);
+void resetLoopProfile();
+
+// ================================
+// PROMETHEUS TEXT FORMAT
+// ================================
+
+// Writes metric families in the Prometheus text exposition format.
+// Labels are passed preformatted, e.g. "route=\"/api/scan\"", or nullptr.
+class PrometheusWriter {
+public:
+    explicit PrometheusWriter(Print& out);
+
+    void family(const char* name, const char* type, const char* help);
+    void sample(const char* name, const char* labels, unsigned long value);
+    void sample(const char* name, const char* labels, double value);
+    void histogram(const char* name, const char* labels, const LatencyHistogram& histogram);
+
+    size_t bytesWritten() const;
+
+private:
+    Print& _out;
+    size_t _written;
+
+    void _series(const char* name, const char* suffix, const char* labels, const char* extraLabel);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,154 @@
+#include "scheduler.h"
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+Scheduler::Scheduler() :
+    _jobCount(0),
+    _queue(nullptr),
+    _busyCycles(0)
+{
+}
+
+bool Scheduler::begin() {
+    _queue = xQueueCreate(SCHEDULER_QUEUE_LENGTH, sizeof(JobId));
+
+    if (!_queue) {
+        DEBUG_E("Failed to create scheduler event queue");
+        return false;
+    }
+
+    _wheel.begin(millis());
+    return true;
+}
+
+JobId Scheduler::addJob(const char* name, JobFunction function, unsigned long intervalMs, LoopStage stage) {
+    if (_jobCount >= SCHEDULER_MAX_JOBS) {
+        DEBUG_E("Scheduler full, job %s not added", name);
+        return INVALID_JOB;
+    }
+
+    Job& job = _jobs[_jobCount];
+    job.name = name;
+    job.function = function;
+    job.interval = intervalMs;
+    job.triggered = false;
+    job.stage = stage;
+    job.timer.callback = _onTimer;
+    job.timer.context = &job;
+    job.owner = this;
+
+    if (intervalMs > 0) {
+        _wheel.schedule(job.timer, intervalMs);
+    }
+
+    DEBUG_D("Scheduled job %s every %lu ms", name, intervalMs);
+    return _jobCount++;
+}
+
+// ================================
+// EVENTS
+// ================================
+
+void Scheduler::trigger(JobId id) {
+    if (_queue && id != INVALID_JOB) {
+        xQueueSend(_queue, &id, 0);
+    }
+}
+
+void IRAM_ATTR Scheduler::triggerFromISR(JobId id) {
+    BaseType_t woken = pdFALSE;
+
+    if (_queue && id != INVALID_JOB) {
+        xQueueSendFromISR(_queue, &id, &woken);
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+void Scheduler::defer(JobId id, unsigned long delayMs) {
+    if (id < _jobCount) {
+        _wheel.schedule(_jobs[id].timer, delayMs);
+    }
+}
+
+void Scheduler::setInterval(JobId id, unsigned long intervalMs) {
+    if (id >= _jobCount) {
+        return;
+    }
+
+    Job& job = _jobs[id];
+    job.interval = intervalMs;
+
+    if (intervalMs > 0) {
+        _wheel.schedule(job.timer, intervalMs);
+    } else {
+        _wheel.cancel(job.timer);
+    }
+}
+
+void Scheduler::cancel(JobId id) {
+    if (id < _jobCount) {
+        _wheel.cancel(_jobs[id].timer);
+    }
+}
+
+// ================================
+// MAIN LOOP
+// ================================
+
+void Scheduler::runOnce() {
+    JobId id;
+    unsigned long wait = _wheel.msUntilNext(millis(), SCHEDULER_MAX_SLEEP_MS);
+
+    // Sleep until the next deadline unless an event arrives first
+    if (_queue && xQueueReceive(_queue, &id, pdMS_TO_TICKS(wait)) == pdTRUE) {
+        do {
+            if (id < _jobCount) {
+                _jobs[id].triggered = true;
+            }
+        } while (xQueueReceive(_queue, &id, 0) == pdTRUE);
+
+        // Repeated triggers of one job collapse into a single run
+        for (uint8_t i = 0; i < _jobCount; i++) {
+            if (_jobs[i].triggered) {
+                _jobs[i].triggered = false;
+                _runJob(_jobs[i]);
+            }
+        }
+    }
+
+    _wheel.advance(millis());
+}
+
+uint32_t Scheduler::getBusyCycles() const {
+    return _busyCycles;
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void Scheduler::_onTimer(void* context) {
+    Job* job = static_cast<Job*>(context);
+    job->owner->_runJob(*job);
+}
+
+void Scheduler::_runJob(Job& job) {
+    // Re-arm first so the job can defer() itself
+    if (job.interval > 0) {
+        _wheel.schedule(job.timer, job.interval);
+    } else {
+        _wheel.cancel(job.timer);
+    }
+
+    uint32_t start = metricsTimestamp();
+    
+    {
+        PROFILE_SCOPE(loopStageMetrics[job.stage]);
+        job.function();
+    }
+    
+    _busyCycles += metricsTimestamp() - start;
+}
@@ -0,0 +1,72 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "metrics.h"
+#include "timer_wheel.h"
+
+// ================================
+// EVENT-DRIVEN JOB SCHEDULER
+// ================================
+
+typedef void (*JobFunction)();
+typedef uint8_t JobId;
+
+#define INVALID_JOB 0xFF
+
+// Runs periodic and on-demand jobs from the loop task. Deadlines live in a
+// timer wheel; runOnce() blocks on the event queue until the next one is
+// due or another task, callback or interrupt triggers a job, so the loop
+// sleeps instead of polling.
+class Scheduler {
+public:
+    Scheduler();
+
+    bool begin();
+
+    // Register a job; an interval of 0 means it only runs when triggered
+    JobId addJob(const char* name, JobFunction function, unsigned long intervalMs, LoopStage stage);
+
+    // Run a job as soon as possible (any task / interrupt context)
+    void trigger(JobId id);
+    void IRAM_ATTR triggerFromISR(JobId id);
+
+    // Move a job's next run to delayMs from now (loop task only)
+    void defer(JobId id, unsigned long delayMs);
+
+    // Change a job's period and restart its countdown; 0 makes it
+    // trigger-only (loop task only)
+    void setInterval(JobId id, unsigned long intervalMs);
+
+    // Stop a job's pending run; periodic jobs resume on the next trigger
+    void cancel(JobId id);
+
+    // Wait for the next event or deadline, then run every due job
+    void runOnce();
+    
+    // Cycles spent running jobs since boot; never reset
+    uint32_t getBusyCycles() const;
+
+private:
+    struct Job {
+        const char* name;
+        JobFunction function;
+        unsigned long interval;
+        bool triggered;
+        LoopStage stage;
+        Timer timer;
+        Scheduler* owner;
+    };
+
+    Job _jobs[SCHEDULER_MAX_JOBS];
+    uint8_t _jobCount;
+    QueueHandle_t _queue;
+    TimerWheel _wheel;
+    uint32_t _busyCycles;
+
+    static void _onTimer(void* context);
+    void _runJob(Job& job);
+};
+
+#endif // SCHEDULER_H
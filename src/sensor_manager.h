@@ -1,225 +1,256 @@
- #ifndef SENSOR_MANAGER_H
-#define SENSOR_MANAGER_H
-
-#include <Arduino.h>
-#include <ArduinoJson.h>
-#include <vector>
-#include "config.h"
-
-// ================================
-// SENSOR DATA STRUCTURES
-// ================================
-
-struct SensorReading {
-    float temperature;
-    float humidity;
-    float pressure;
-    float lightLevel;
-    bool motionDetected;
-    float batteryLevel;
-    unsigned long timestamp;
-};
-
-struct SensorStats {
-    float minTemperature;
-    float maxTemperature;
-    float avgTemperature;
-    float minHumidity;
-    float maxHumidity;
-    float avgHumidity;
-    float minPressure;
-    float maxPressure;
-    float avgPressure;
-    float minLightLevel;
-    float maxLightLevel;
-    float avgLightLevel;
-    int motionEvents;
-    unsigned long lastMotionTime;
-    float batteryHealth;
-    unsigned long dataPoints;
-};
-
-struct DeviceStats {
-    unsigned long uptime;
-    uint32_t bootCount;
-    uint32_t totalConnections;
-    size_t freeHeap;
-    size_t totalHeap;
-    float cpuUsage;
-    String wifiSSID;
-    int wifiRSSI;
-    IPAddress localIP;
-    String macAddress;
-    float temperature;
-    bool ledState;
-    int webSocketClients;
-};
-
-// ================================
-// SENSOR MANAGER CLASS
-// ================================
-
-class SensorManager {
-public:
-    // Constructor
-    SensorManager();
-    
-    // Initialization
-    void begin();
-    void end();
-    
-    // Main update loop
-    void update();
-    
-    // Sensor Control
-    void enableSensor(const String& sensorName, bool enabled);
-    bool isSensorEnabled(const String& sensorName);
-    void setUpdateInterval(unsigned long interval);
-    unsigned long getUpdateInterval();
-    
-    // Data Access
-    SensorReading getCurrentReading();
-    std::vector<SensorReading> getHistory();
-    SensorStats getStatistics();
-    DeviceStats getDeviceStatistics();
-    
-    // JSON Output
-    String getSensorDataJSON();
-    String getSensorHistoryJSON();
-    String getSensorStatsJSON();
-    String getDeviceStatsJSON();
-    String getAllDataJSON();
-    
-    // Data Management
-    void clearHistory();
-    void resetStatistics();
-    int getHistorySize();
-    void setHistorySize(int size);
-    
-    // Calibration (for real sensors)
-    void calibrateTemperature(float offset);
-    void calibrateHumidity(float offset);
-    void calibratePressure(float offset);
-    
-    // Battery Management
-    void setBatteryLevel(float level);
-    float getBatteryLevel();
-    bool isBatteryLow();
-    
-    // Motion Detection
-    bool isMotionDetected();
-    unsigned long getLastMotionTime();
-    int getMotionEventCount();
-    
-    // Device Statistics Callbacks
-    void setUptimeCallback(std::function<unsigned long()> callback);
-    void setBootCountCallback(std::function<uint32_t()> callback);
-    void setTotalConnectionsCallback(std::function<uint32_t()> callback);
-    void setWiFiInfoCallback(std::function<String()> ssidCallback, std::function<int()> rssiCallback);
-    void setLEDStateCallback(std::function<bool()> callback);
-    void setWebSocketClientsCallback(std::function<int()> callback);
-
-private:
-    // Current sensor reading
-    SensorReading _currentReading;
-    
-    // Historical data
-    std::vector<SensorReading> _history;
-    int _maxHistorySize;
-    
-    // Statistics
-    SensorStats _stats;
-    bool _statsValid;
-    
-    // Sensor states
-    bool _temperatureEnabled;
-    bool _humidityEnabled;
-    bool _pressureEnabled;
-    bool _lightEnabled;
-    bool _motionEnabled;
-    bool _batteryEnabled;
-    
-    // Timing
-    unsigned long _lastUpdate;
-    unsigned long _updateInterval;
-    unsigned long _lastStatsUpdate;
-    
-    // Simulation parameters
-    float _tempBase;
-    float _tempTrend;
-    float _humidityBase;
-    float _humidityTrend;
-    float _pressureBase;
-    float _pressureTrend;
-    float _lightBase;
-    float _lightTrend;
-    
-    // Motion simulation
-    bool _motionActive;
-    unsigned long _motionStartTime;
-    unsigned long _lastMotionEvent;
-    int _motionEventCount;
-    
-    // Battery simulation
-    float _batteryLevel;
-    bool _batteryCharging;
-    unsigned long _lastBatteryUpdate;
-    
-    // Calibration offsets
-    float _tempOffset;
-    float _humidityOffset;
-    float _pressureOffset;
-    
-    // Device statistics callbacks
-    std::function<unsigned long()> _uptimeCallback;
-    std::function<uint32_t()> _bootCountCallback;
-    std::function<uint32_t()> _totalConnectionsCallback;
-    std::function<String()> _wifiSSIDCallback;
-    std::function<int()> _wifiRSSICallback;
-    std::function<bool()> _ledStateCallback;
-    std::function<int()> _webSocketClientsCallback;
-    
-    // Private methods
-    void _updateSensors();
-    void _updateTemperature();
-    void _updateHumidity();
-    void _updatePressure();
-    void _updateLightLevel();
-    void _updateMotionDetection();
-    void _updateBatteryLevel();
-    void _addToHistory(const SensorReading& reading);
-    void _updateStatistics();
-    void _calculateStatistics();
-    float _generateSensorValue(float base, float variation, float& trend);
-    float _applyNoise(float value, float noiseLevel);
-    bool _shouldTriggerMotion();
-    void _simulateBatteryDrain();
-    String _formatTimestamp(unsigned long timestamp);
-    String _boolToString(bool value);
-};
-
-// ================================
-// SENSOR CONFIGURATION
-// ================================
-
-enum class SensorType {
-    TEMPERATURE,
-    HUMIDITY,
-    PRESSURE,
-    LIGHT,
-    MOTION,
-    BATTERY
-};
-
-struct SensorConfig {
-    SensorType type;
-    bool enabled;
-    float minValue;
-    float maxValue;
-    float currentValue;
-    String unit;
-    String name;
-};
-
-#endif // SENSOR_MANAGER_H
-
+ #ifndef SENSOR_MANAGER_H
+#define SENSOR_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "config.h"
+#include "api_fields.h"
+#include "json_writer.h"
+#include "heap_telemetry.h"
+
+// ================================
+// SENSOR DATA STRUCTURES
+// ================================
+
+struct SensorReading {
+    float temperature;
+    float humidity;
+    float pressure;
+    float lightLevel;
+    bool motionDetected;
+    float batteryLevel;
+    unsigned long timestamp;
+};
+
+typedef std::vector<SensorReading, TaggedAllocator<SensorReading, HEAP_TAG_SENSORS>> SensorHistory;
+
+struct SensorStats {
+    float minTemperature;
+    float maxTemperature;
+    float avgTemperature;
+    float minHumidity;
+    float maxHumidity;
+    float avgHumidity;
+    float minPressure;
+    float maxPressure;
+    float avgPressure;
+    float minLightLevel;
+    float maxLightLevel;
+    float avgLightLevel;
+    int motionEvents;
+    unsigned long lastMotionTime;
+    float batteryHealth;
+    unsigned long dataPoints;
+};
+
+struct DeviceStats {
+    unsigned long uptime;
+    uint32_t bootCount;
+    uint32_t totalConnections;
+    size_t freeHeap;
+    size_t totalHeap;
+    size_t largestFreeBlock;
+    size_t minFreeHeap;
+    float heapFragmentation;
+    float cpuUsage;
+    char wifiSSID[WIFI_SSID_MAX_LENGTH + 1];
+    int wifiRSSI;
+    IPAddress localIP;
+    char macAddress[MAC_ADDRESS_LENGTH];
+    float temperature;
+    bool ledState;
+    int webSocketClients;
+};
+
+// Device statistics sources. Plain function pointers, so collecting stats
+// is a direct call with no captured state behind it.
+typedef unsigned long (*UptimeProvider)();
+typedef uint32_t (*CounterProvider)();
+typedef int (*IntProvider)();
+typedef bool (*BoolProvider)();
+typedef const char* (*TextProvider)();
+
+// Told the new period when setUpdateInterval() changes it
+typedef void (*IntervalCallback)(unsigned long intervalMs);
+
+// Called per reading by forEachReadingSince(), with the history locked
+typedef void (*ReadingVisitor)(const SensorReading& reading, void* context);
+
+// ================================
+// SENSOR MANAGER CLASS
+// ================================
+
+class SensorManager {
+public:
+    // Constructor
+    SensorManager();
+    
+    // Initialization
+    void begin();
+    void end();
+    
+    // Main update loop (scheduled jobs)
+    void update();
+    void updateStatistics();
+    
+    // Sensor Control
+    void enableSensor(const String& sensorName, bool enabled);
+    bool isSensorEnabled(const String& sensorName);
+    void setUpdateInterval(unsigned long interval);     // Loop task only
+    unsigned long getUpdateInterval();
+    void setUpdateIntervalCallback(IntervalCallback callback);
+    
+    // Data Access
+    SensorReading getCurrentReading();
+    SensorHistory getHistory();
+    int forEachReadingSince(unsigned long timestamp, ReadingVisitor visitor, void* context);
+    SensorStats getStatistics();
+    DeviceStats getDeviceStatistics(uint32_t fields = FIELD_ALL);
+    
+    // JSON Output (fields: ApiField projection mask)
+    String getSensorDataJSON(uint32_t fields = FIELD_ALL);
+    String getReadingJSON(const SensorReading& reading, uint32_t fields = FIELD_ALL);
+    String getSensorHistoryJSON();
+    size_t writeSensorHistoryCompact(Print& out, uint32_t fields = FIELD_ALL);
+    String getSensorStatsJSON();
+    String getDeviceStatsJSON(uint32_t fields = FIELD_ALL);
+    String getAllDataJSON();
+    
+    // Data Management
+    void clearHistory();
+    void resetStatistics();
+    int getHistorySize();
+    void setHistorySize(int size);
+    
+    // Calibration (for real sensors)
+    void calibrateTemperature(float offset);
+    void calibrateHumidity(float offset);
+    void calibratePressure(float offset);
+    
+    // Battery Management
+    void setBatteryLevel(float level);
+    float getBatteryLevel();
+    bool isBatteryLow();
+    
+    // Motion Detection
+    bool isMotionDetected();
+    unsigned long getLastMotionTime();
+    int getMotionEventCount();
+    
+    // Device Statistics Callbacks
+    void setUptimeCallback(UptimeProvider callback);
+    void setBootCountCallback(CounterProvider callback);
+    void setTotalConnectionsCallback(CounterProvider callback);
+    void setWiFiInfoCallback(TextProvider ssidCallback, IntProvider rssiCallback, TextProvider macCallback);
+    void setLEDStateCallback(BoolProvider callback);
+    void setWebSocketClientsCallback(IntProvider callback);
+
+private:
+    // Current sensor reading
+    SensorReading _currentReading;
+    
+    // Historical data; written on the loop task, read by the web server
+    // task, so every access goes through _historyLock
+    SensorHistory _history;
+    int _maxHistorySize;
+    SemaphoreHandle_t _historyLock;
+    
+    // Statistics
+    SensorStats _stats;
+    bool _statsValid;
+    
+    // Sensor states
+    bool _temperatureEnabled;
+    bool _humidityEnabled;
+    bool _pressureEnabled;
+    bool _lightEnabled;
+    bool _motionEnabled;
+    bool _batteryEnabled;
+    
+    // Timing
+    unsigned long _updateInterval;
+    IntervalCallback _updateIntervalCallback;  // Re-arms the scheduled update job
+    
+    // Simulation parameters
+    float _tempBase;
+    float _tempTrend;
+    float _humidityBase;
+    float _humidityTrend;
+    float _pressureBase;
+    float _pressureTrend;
+    float _lightBase;
+    float _lightTrend;
+    
+    // Motion simulation
+    bool _motionActive;
+    unsigned long _motionStartTime;
+    unsigned long _lastMotionEvent;
+    int _motionEventCount;
+    
+    // Battery simulation
+    float _batteryLevel;
+    bool _batteryCharging;
+    unsigned long _lastBatteryUpdate;
+    
+    // Calibration offsets
+    float _tempOffset;
+    float _humidityOffset;
+    float _pressureOffset;
+    
+    // Device statistics callbacks
+    UptimeProvider _uptimeCallback;
+    CounterProvider _bootCountCallback;
+    CounterProvider _totalConnectionsCallback;
+    TextProvider _wifiSSIDCallback;
+    IntProvider _wifiRSSICallback;
+    TextProvider _macAddressCallback;
+    BoolProvider _ledStateCallback;
+    IntProvider _webSocketClientsCallback;
+    
+    // Private methods
+    void _updateSensors();
+    void _updateTemperature();
+    void _updateHumidity();
+    void _updatePressure();
+    void _updateLightLevel();
+    void _updateMotionDetection();
+    void _updateBatteryLevel();
+    void _addToHistory(const SensorReading& reading);
+    void _updateStatistics();
+    void _calculateStatistics();
+    float _generateSensorValue(float base, float variation, float& trend);
+    float _applyNoise(float value, float noiseLevel);
+    bool _shouldTriggerMotion();
+    void _simulateBatteryDrain();
+    void _writeHistoryColumn(JsonWriter& json, const char* name, float SensorReading::* channel, float scale);
+    void _writeHistoryColumn(JsonWriter& json, const char* name, bool SensorReading::* flag);
+    String _formatTimestamp(unsigned long timestamp);
+    String _boolToString(bool value);
+};
+
+// ================================
+// SENSOR CONFIGURATION
+// ================================
+
+enum class SensorType {
+    TEMPERATURE,
+    HUMIDITY,
+    PRESSURE,
+    LIGHT,
+    MOTION,
+    BATTERY
+};
+
+struct SensorConfig {
+    SensorType type;
+    bool enabled;
+    float minValue;
+    float maxValue;
+    float currentValue;
+    const char* unit;       // Static strings
+    const char* name;
+};
+
+#endif // SENSOR_MANAGER_H
+
@@ -0,0 +1,202 @@
+#include "timer_wheel.h"
+
+#define TIMER_SLOT_OVERFLOW  (2 * TIMER_WHEEL_SLOTS)
+#define TIMER_SLOT_DETACHED  0xFF
+
+// Rotate an occupancy bitmap so that bit 0 is the given slot
+static inline uint64_t _rotate(uint64_t bitmap, uint8_t slot) {
+    return slot ? (bitmap >> slot) | (bitmap << (TIMER_WHEEL_SLOTS - slot)) : bitmap;
+}
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+TimerWheel::TimerWheel() :
+    _overflow(nullptr),
+    _currentTick(0),
+    _lastMillis(0),
+    _pendingMs(0)
+{
+    memset(_slots, 0, sizeof(_slots));
+    _occupied[0] = 0;
+    _occupied[1] = 0;
+}
+
+void TimerWheel::begin(unsigned long now) {
+    _lastMillis = now;
+    _pendingMs = 0;
+}
+
+// ================================
+// SCHEDULING
+// ================================
+
+void TimerWheel::schedule(Timer& timer, unsigned long delayMs) {
+    if (timer.pending()) {
+        _unlink(timer);
+    }
+
+    // Tick _currentTick + n is processed once (n + 1) ticks have elapsed
+    uint32_t ticks = (delayMs + _pendingMs + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+    timer.expires = _currentTick + (ticks ? ticks - 1 : 0);
+    _insert(timer);
+}
+
+void TimerWheel::cancel(Timer& timer) {
+    if (timer.pending()) {
+        _unlink(timer);
+    }
+}
+
+void TimerWheel::advance(unsigned long now) {
+    _pendingMs += now - _lastMillis;
+    _lastMillis = now;
+
+    while (_pendingMs >= TIMER_WHEEL_TICK_MS) {
+        _pendingMs -= TIMER_WHEEL_TICK_MS;
+        uint8_t index = _currentTick & TIMER_WHEEL_MASK;
+
+        // Start of a revolution: pull the next level 1 slot down
+        if (index == 0) {
+            uint8_t block = (_currentTick >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK;
+            _reinsertAll(_detach(_slots[TIMER_WHEEL_SLOTS + block]));
+
+            if (block == 0) {
+                _reinsertAll(_detach(_overflow));
+            }
+        }
+
+        Timer* expired = _detach(_slots[index]);
+
+        if (expired) {
+            expired->pprev = &expired;
+        }
+
+        _currentTick++;
+
+        // Unlink before each callback so it can re-arm its own timer or
+        // cancel others still waiting in this slot
+        while (expired) {
+            Timer* timer = expired;
+            _unlink(*timer);
+            timer->callback(timer->context);
+        }
+    }
+}
+
+unsigned long TimerWheel::msUntilNext(unsigned long now, unsigned long limitMs) const {
+    uint8_t index = _currentTick & TIMER_WHEEL_MASK;
+    uint8_t block = (_currentTick >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK;
+    uint32_t ticks = UINT32_MAX;
+
+    if (_occupied[0]) {
+        ticks = __builtin_ctzll(_rotate(_occupied[0], index));
+    }
+
+    // Cascades may bring timers down before the level 0 deadline
+    if (index == 0 && ((_occupied[1] >> block) & 1)) {
+        ticks = 0;
+    } else if (_occupied[1]) {
+        uint8_t next = __builtin_ctzll(_rotate(_occupied[1], (block + 1) & TIMER_WHEEL_MASK));
+        ticks = min(ticks, (uint32_t)(next + 1) * TIMER_WHEEL_SLOTS - index);
+    }
+
+    if (_overflow) {
+        uint32_t wrap = (index == 0 && block == 0) ? 0 :
+                        (uint32_t)(TIMER_WHEEL_SLOTS - block) * TIMER_WHEEL_SLOTS - index;
+        ticks = min(ticks, wrap);
+    }
+
+    if (ticks == UINT32_MAX) {
+        return limitMs;
+    }
+
+    unsigned long elapsed = _pendingMs + (now - _lastMillis);
+    unsigned long due = (ticks + 1) * TIMER_WHEEL_TICK_MS;
+
+    if (due <= elapsed) {
+        return 0;
+    }
+
+    return min(due - elapsed, limitMs);
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void TimerWheel::_insert(Timer& timer) {
+    uint32_t delta = timer.expires - _currentTick;
+
+    if ((int32_t)delta < 0) {
+        timer.expires = _currentTick;
+        delta = 0;
+    }
+
+    if (delta < TIMER_WHEEL_SLOTS) {
+        uint8_t slot = timer.expires & TIMER_WHEEL_MASK;
+        _link(_slots[slot], timer, slot);
+        _occupied[0] |= 1ULL << slot;
+    } else if (delta < TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS) {
+        uint8_t slot = (timer.expires >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK;
+        _link(_slots[TIMER_WHEEL_SLOTS + slot], timer, TIMER_WHEEL_SLOTS + slot);
+        _occupied[1] |= 1ULL << slot;
+    } else {
+        _link(_overflow, timer, TIMER_SLOT_OVERFLOW);
+    }
+}
+
+void TimerWheel::_link(Timer*& head, Timer& timer, uint8_t slot) {
+    timer.next = head;
+    timer.pprev = &head;
+    timer.slot = slot;
+
+    if (head) {
+        head->pprev = &timer.next;
+    }
+
+    head = &timer;
+}
+
+void TimerWheel::_unlink(Timer& timer) {
+    *timer.pprev = timer.next;
+
+    if (timer.next) {
+        timer.next->pprev = timer.pprev;
+    }
+
+    if (timer.slot < TIMER_SLOT_OVERFLOW && !_slots[timer.slot]) {
+        _occupied[timer.slot / TIMER_WHEEL_SLOTS] &= ~(1ULL << (timer.slot & TIMER_WHEEL_MASK));
+    }
+
+    timer.next = nullptr;
+    timer.pprev = nullptr;
+}
+
+// Take a whole list out of the wheel; its timers stay linked to each
+// other and the caller must repoint the head's pprev before unlinking
+Timer* TimerWheel::_detach(Timer*& head) {
+    Timer* list = head;
+    head = nullptr;
+
+    for (Timer* timer = list; timer; timer = timer->next) {
+        timer->slot = TIMER_SLOT_DETACHED;
+    }
+
+    if (&head >= _slots && &head < _slots + TIMER_SLOT_OVERFLOW) {
+        uint8_t slot = &head - _slots;
+        _occupied[slot / TIMER_WHEEL_SLOTS] &= ~(1ULL << (slot & TIMER_WHEEL_MASK));
+    }
+
+    return list;
+}
+
+void TimerWheel::_reinsertAll(Timer* list) {
+    while (list) {
+        Timer* timer = list;
+        list = timer->next;
+        timer->next = nullptr;
+        _insert(*timer);
+    }
+}
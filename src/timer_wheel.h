@@ -0,0 +1,68 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ================================
+// HIERARCHICAL TIMER WHEEL
+// ================================
+
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK  (TIMER_WHEEL_SLOTS - 1)
+
+typedef void (*TimerCallback)(void* context);
+
+// Intrusive timer node; owned by the caller, linked into the wheel while
+// pending. Never copy or destroy a pending timer.
+struct Timer {
+    Timer* next;
+    Timer** pprev;
+    uint32_t expires;       // Absolute tick
+    uint8_t slot;
+    TimerCallback callback;
+    void* context;
+
+    Timer() : next(nullptr), pprev(nullptr), expires(0), slot(0), callback(nullptr), context(nullptr) {}
+
+    bool pending() const { return pprev != nullptr; }
+};
+
+// Two-level wheel of TIMER_WHEEL_TICK_MS ticks. Level 0 holds timers due
+// within one revolution, level 1 holds one slot per revolution and is
+// cascaded down as the wheel turns; anything further out waits in an
+// overflow list. Scheduling and cancelling are O(1), and occupancy
+// bitmaps answer "time until the next deadline" without walking slots.
+// Time is tracked as elapsed ticks, so millis() wraparound is harmless.
+class TimerWheel {
+public:
+    TimerWheel();
+
+    void begin(unsigned long now);
+
+    // (Re)arm a timer to fire delayMs from the last advance()
+    void schedule(Timer& timer, unsigned long delayMs);
+    void cancel(Timer& timer);
+
+    // Run the callbacks of every timer that expired up to now
+    void advance(unsigned long now);
+
+    // Milliseconds until the next timer may fire, capped at limitMs
+    unsigned long msUntilNext(unsigned long now, unsigned long limitMs) const;
+
+private:
+    Timer* _slots[2 * TIMER_WHEEL_SLOTS];
+    Timer* _overflow;
+    uint64_t _occupied[2];
+    uint32_t _currentTick;      // Next tick to process
+    unsigned long _lastMillis;
+    unsigned long _pendingMs;   // Elapsed time not yet turned into ticks
+
+    void _insert(Timer& timer);
+    void _link(Timer*& head, Timer& timer, uint8_t slot);
+    void _unlink(Timer& timer);
+    Timer* _detach(Timer*& head);
+    void _reinsertAll(Timer* list);
+};
+
+#endif // TIMER_WHEEL_H
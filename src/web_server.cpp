@@ -1,472 +1,1800 @@
- #include "web_server.h"
-#include "wifi_manager.h"
-#include "sensor_manager.h"
-#include "html_pages.h"
-
-// Static instance pointer
-WebServerManager* WebServerManager::_instance = nullptr;
-
-// ================================
-// CONSTRUCTOR & INITIALIZATION
-// ================================
-
-WebServerManager::WebServerManager() :
-    _server(nullptr),
-    _webSocket(nullptr),
-    _wifiManager(nullptr),
-    _sensorManager(nullptr),
-    _isRunning(false),
-    _startTime(0),
-    _requestCount(0),
-    _errorCount(0),
-    _lastBroadcast(0),
-    _onDeviceNameChangeCallback(nullptr),
-    _onLEDControlCallback(nullptr),
-    _onFactoryResetCallback(nullptr),
-    _onRestartCallback(nullptr)
-{
-    _instance = this;
-}
-
-void WebServerManager::begin() {
-    DEBUG_I("Initializing Web Server Manager...");
-    
-    // Create server instance
-    _server = new AsyncWebServer(WEB_SERVER_PORT);
-    _webSocket = new AsyncWebSocket(WEBSOCKET_PATH);
-    
-    // Setup routes and handlers
-    _setupRoutes();
-    _setupWebSocketHandlers();
-    _setupCORSHeaders();
-    
-    // Start server
-    start();
-    
-    DEBUG_I("Web Server Manager initialized successfully");
-}
-
-void WebServerManager::end() {
-    DEBUG_I("Shutting down Web Server Manager...");
-    
-    stop();
-    
-    if (_webSocket) {
-        delete _webSocket;
-        _webSocket = nullptr;
-    }
-    
-    if (_server) {
-        delete _server;
-        _server = nullptr;
-    }
-    
-    DEBUG_I("Web Server Manager shutdown complete");
-}
-
-// ================================
-// SERVER CONTROL
-// ================================
-
-void WebServerManager::start() {
-    if (_isRunning || !_server) {
-        return;
-    }
-    
-    DEBUG_I("Starting web server on port %d", WEB_SERVER_PORT);
-    
-    _server->begin();
-    _isRunning = true;
-    _startTime = millis();
-    
-    DEBUG_I("Web server started successfully");
-}
-
-void WebServerManager::stop() {
-    if (!_isRunning || !_server) {
-        return;
-    }
-    
-    DEBUG_I("Stopping web server");
-    
-    _server->end();
-    _isRunning = false;
-    
-    DEBUG_I("Web server stopped");
-}
-
-bool WebServerManager::isRunning() {
-    return _isRunning;
-}
-
-// ================================
-// MAIN LOOP HANDLER
-// ================================
-
-void WebServerManager::handleClient() {
-    // WebSocket cleanup
-    if (_webSocket) {
-        _webSocket->cleanupClients();
-    }
-    
-    // Periodic sensor data broadcast
-    unsigned long currentTime = millis();
-    if (currentTime - _lastBroadcast >= SENSOR_UPDATE_INTERVAL) {
-        broadcastSensorData();
-        _lastBroadcast = currentTime;
-    }
-}
-
-// ================================
-// WEBSOCKET MANAGEMENT
-// ================================
-
-void WebServerManager::broadcastMessage(const String& message) {
-    if (_webSocket && _webSocket->count() > 0) {
-        _webSocket->textAll(message);
-        DEBUG_V("Broadcast message to %d clients", _webSocket->count());
-    }
-}
-
-void WebServerManager::broadcastSensorData() {
-    if (_sensorManager) {
-        String sensorData = _sensorManager->getSensorDataJSON();
-        broadcastMessage(sensorData);
-    }
-}
-
-void WebServerManager::broadcastDeviceStats() {
-    if (_sensorManager) {
-        String deviceStats = _sensorManager->getDeviceStatsJSON();
-        broadcastMessage(deviceStats);
-    }
-}
-
-int WebServerManager::getWebSocketClientCount() {
-    return _webSocket ? _webSocket->count() : 0;
-}
-
-// ================================
-// MANAGER REFERENCES
-// ================================
-
-void WebServerManager::setWiFiManager(WiFiManager* wifiManager) {
-    _wifiManager = wifiManager;
-}
-
-void WebServerManager::setSensorManager(SensorManager* sensorManager) {
-    _sensorManager = sensorManager;
-}
-
-// ================================
-// CALLBACK REGISTRATION
-// ================================
-
-void WebServerManager::onDeviceNameChange(std::function<void(const String&)> callback) {
-    _onDeviceNameChangeCallback = callback;
-}
-
-void WebServerManager::onLEDControl(std::function<void(bool)> callback) {
-    _onLEDControlCallback = callback;
-}
-
-void WebServerManager::onFactoryReset(std::function<void()> callback) {
-    _onFactoryResetCallback = callback;
-}
-
-void WebServerManager::onRestart(std::function<void()> callback) {
-    _onRestartCallback = callback;
-}
-
-// ================================
-// ROUTE SETUP
-// ================================
-
-void WebServerManager::_setupRoutes() {
-    if (!_server) return;
-    
-    DEBUG_I("Setting up web server routes...");
-    
-    // Root page handler
-    _server->on("/", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        _handleRoot(request);
-    });
-    
-    // API Routes
-    _server->on((API_PREFIX + API_SCAN).c_str(), HTTP_GET, [this](AsyncWebServerRequest* request) {
-        _handleAPIScan(request);
-    });
-    
-    _server->on((API_PREFIX + API_CONNECT).c_str(), HTTP_POST, [this](AsyncWebServerRequest* request) {
-        _handleAPIConnect(request);
-    });
-    
-    _server->on((API_PREFIX + API_STATUS).c_str(), HTTP_GET, [this](AsyncWebServerRequest* request) {
-        _handleAPIStatus(request);
-    });
-    
-    _server->on((API_PREFIX + API_SENSOR_DATA).c_str(), HTTP_GET, [this](AsyncWebServerRequest* request) {
-        _handleAPISensorData(request);
-    });
-    
-    _server->on((API_PREFIX + API_DEVICE_STATS).c_str(), HTTP_GET, [this](AsyncWebServerRequest* request) {
-        _handleAPIDeviceStats(request);
-    });
-    
-    _server->on((API_PREFIX + API_DEVICE_NAME).c_str(), HTTP_POST, [this](AsyncWebServerRequest* request) {
-        _handleAPIDeviceName(request);
-    });
-    
-    _server->on((API_PREFIX + API_LED_CONTROL).c_str(), HTTP_POST, [this](AsyncWebServerRequest* request) {
-        _handleAPILEDControl(request);
-    });
-    
-    _server->on((API_PREFIX + API_FACTORY_RESET).c_str(), HTTP_POST, [this](AsyncWebServerRequest* request) {
-        _handleAPIFactoryReset(request);
-    });
-    
-    _server->on((API_PREFIX + API_RESTART).c_str(), HTTP_POST, [this](AsyncWebServerRequest* request) {
-        _handleAPIRestart(request);
-    });
-    
-    // 404 handler
-    _server->onNotFound([this](AsyncWebServerRequest* request) {
-        _handleNotFound(request);
-    });
-    
-    DEBUG_I("Web server routes configured");
-}
-
-void WebServerManager::_setupWebSocketHandlers() {
-    if (!_webSocket || !_server) return;
-    
-    DEBUG_I("Setting up WebSocket handlers...");
-    
-    _webSocket->onEvent(_staticWebSocketEvent);
-    _server->addHandler(_webSocket);
-    
-    DEBUG_I("WebSocket handlers configured");
-}
-
-void WebServerManager::_setupCORSHeaders() {
-    if (!_server) return;
-    
-    // Add CORS headers to all responses
-    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
-    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
-    DefaultHeaders::Instance().addHeader("Access-Control-Max-Age", String(CORS_MAX_AGE));
-    
-    DEBUG_I("CORS headers configured");
-}
-
-// ================================
-// PAGE HANDLERS
-// ================================
-
-void WebServerManager::_handleRoot(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_D("Handling root request from: %s", request->client()->remoteIP().toString().c_str());
-    
-    String html;
-    
-    if (_wifiManager && _wifiManager->isConnected()) {
-        // Show dashboard if connected to WiFi
-        html = getDashboardHTML();
-    } else {
-        // Show WiFi setup if not connected
-        html = getWiFiSetupHTML();
-    }
-    
-    AsyncWebServerResponse* response = request->beginResponse(200, "text/html", html);
-    _addCORSHeaders(response);
-    request->send(response);
-}
-
-void WebServerManager::_handleNotFound(AsyncWebServerRequest* request) {
-    _errorCount++;
-    
-    DEBUG_W("404 Not Found: %s", request->url().c_str());
-    
-    // For captive portal, redirect to root
-    if (_wifiManager && _wifiManager->isAccessPointActive()) {
-        AsyncWebServerResponse* response = request->beginResponse(302);
-        response->addHeader("Location", "http://" + _wifiManager->getAccessPointIP().toString());
-        _addCORSHeaders(response);
-        request->send(response);
-    } else {
-        _sendErrorResponse(request, "Page not found", 404);
-    }
-}
-
-// ================================
-// API HANDLERS
-// ================================
-
-void WebServerManager::_handleAPIScan(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_D("API: WiFi scan request");
-    
-    if (!_wifiManager) {
-        _sendErrorResponse(request, "WiFi manager not available");
-        return;
-    }
-    
-    // Start network scan
-    int networkCount = _wifiManager->scanNetworks();
-    
-    if (networkCount >= 0) {
-        String networksJSON = _wifiManager->getScannedNetworksJSON();
-        _sendJSONResponse(request, networksJSON);
-    } else {
-        _sendErrorResponse(request, "Network scan failed");
-    }
-}
-
-void WebServerManager::_handleAPIConnect(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_D("API: WiFi connect request");
-    
-    if (!_wifiManager) {
-        _sendErrorResponse(request, "WiFi manager not available");
-        return;
-    }
-    
-    // Get POST parameters
-    String ssid = "";
-    String password = "";
-    
-    if (request->hasParam("ssid", true)) {
-        ssid = request->getParam("ssid", true)->value();
-    }
-    
-    if (request->hasParam("password", true)) {
-        password = request->getParam("password", true)->value();
-    }
-    
-    if (ssid.length() == 0) {
-        _sendErrorResponse(request, "SSID is required");
-        return;
-    }
-    
-    // Attempt connection
-    bool connected = _wifiManager->connectToWiFi(ssid, password);
-    
-    if (connected) {
-        String response = "{\"success\":true,\"message\":\"Connected to " + ssid + "\"}";
-        _sendJSONResponse(request, response);
-    } else {
-        _sendErrorResponse(request, "Failed to connect to " + ssid);
-    }
-}
-
-void WebServerManager::_handleAPIStatus(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_V("API: Status request");
-    
-    String statusJSON = "{\"server\":" + getServerStatus();
-    
-    if (_wifiManager) {
-        statusJSON += ",\"wifi\":" + _wifiManager->getStatusJSON();
-    }
-    
-    if (_sensorManager) {
-        statusJSON += ",\"sensors\":" + _sensorManager->getSensorDataJSON();
-    }
-    
-    statusJSON += "}";
-    
-    _sendJSONResponse(request, statusJSON);
-}
-
-void WebServerManager::_handleAPISensorData(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_V("API: Sensor data request");
-    
-    if (_sensorManager) {
-        String sensorData = _sensorManager->getSensorDataJSON();
-        _sendJSONResponse(request, sensorData);
-    } else {
-        _sendErrorResponse(request, "Sensor manager not available");
-    }
-}
-
-void WebServerManager::_handleAPIDeviceStats(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_V("API: Device stats request");
-    
-    if (_sensorManager) {
-        String deviceStats = _sensorManager->getDeviceStatsJSON();
-        _sendJSONResponse(request, deviceStats);
-    } else {
-        _sendErrorResponse(request, "Sensor manager not available");
-    }
-}
-
-void WebServerManager::_handleAPIDeviceName(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_D("API: Device name change request");
-    
-    String newName = "";
-    
-    if (request->hasParam("name", true)) {
-        newName = request->getParam("name", true)->value();
-    }
-    
-    if (!_validateDeviceName(newName)) {
-        _sendErrorResponse(request, "Invalid device name. Must be 3-32 characters, alphanumeric with hyphens/underscores only");
-        return;
-    }
-    
-    // Call the callback to change device name
-    if (_onDeviceNameChangeCallback) {
-        _onDeviceNameChangeCallback(newName);
-        
-        String response = "{\"success\":true,\"message\":\"Device name changed to: " + newName + "\"}";
-        _sendJSONResponse(request, response);
-    } else {
-        _sendErrorResponse(request, "Device name change not supported");
-    }
-}
-
-void WebServerManager::_handleAPILEDControl(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_D("API: LED control request");
-    
-    if (!request->hasParam("state", true)) {
-        _sendErrorResponse(request, "LED state parameter required");
-        return;
-    }
-    
-    String stateParam = request->getParam("state", true)->value();
-    bool ledState = (stateParam == "true" || stateParam == "1" || stateParam == "on");
-    
-    if (_onLEDControlCallback) {
-        _onLEDControlCallback(ledState);
-        
-        String response = "{\"success\":true,\"message\":\"LED turned " + String(ledState ? "on" : "off") + "\"}";
-        _sendJSONResponse(request, response);
-    } else {
-        _sendErrorResponse(request, "LED control not supported");
-    }
-}
-
-void WebServerManager::_handleAPIFactoryReset(AsyncWebServerRequest* request) {
-    _requestCount++;
-    
-    DEBUG_I("API: Factory reset request");
-    
-    String response = "{\"success\":true,\"message\":\"Factory reset initiated. Device will restart in 3 seconds.\"}";
-    _sendJSONResponse(request, response);
-    
-    // Delay and then call factory reset
-    if (_onFac
-
+ #include "web_server.h"
+#include "wifi_manager.h"
+#include "sensor_manager.h"
+#include "web_assets.h"
+#include "json_writer.h"
+#include "cpu_monitor.h"
+#include "block_pool.h"
+
+// Static instance pointer
+WebServerManager* WebServerManager::_instance = nullptr;
+
+// ================================
+// ROUTE TABLE
+// ================================
+
+// id, method, path, handler, cost - one route per path.
+// Cost decides which routes are shed first when the heap runs low.
+#define API_ROUTES(ROUTE) \
+    ROUTE(ROOT,                    HTTP_GET,             "/",                           _handleRoot,             COST_ESSENTIAL) \
+    ROUTE(SCAN,                    HTTP_GET,             API_PREFIX API_SCAN,           _handleAPIScan,          COST_EXPENSIVE) \
+    ROUTE(CONNECT,                 HTTP_POST,            API_PREFIX API_CONNECT,        _handleAPIConnect,       COST_ESSENTIAL) \
+    ROUTE(CONNECT_STATUS,          HTTP_GET,             API_PREFIX API_CONNECT_STATUS, _handleAPIConnectStatus, COST_ESSENTIAL) \
+    ROUTE(STATUS,                  HTTP_GET,             API_PREFIX API_STATUS,         _handleAPIStatus,        COST_ESSENTIAL) \
+    ROUTE(SENSOR_DATA,             HTTP_GET,             API_PREFIX API_SENSOR_DATA,    _handleAPISensorData,    COST_NORMAL) \
+    ROUTE(SENSOR_HISTORY,          HTTP_GET,             API_PREFIX API_SENSOR_HISTORY, _handleAPISensorHistory, COST_EXPENSIVE) \
+    ROUTE(DEVICE_STATS,            HTTP_GET,             API_PREFIX API_DEVICE_STATS,   _handleAPIDeviceStats,   COST_NORMAL) \
+    ROUTE(DEVICE_NAME,             HTTP_POST,            API_PREFIX API_DEVICE_NAME,    _handleAPIDeviceName,    COST_ESSENTIAL) \
+    ROUTE(LED_CONTROL,             HTTP_POST,            API_PREFIX API_LED_CONTROL,    _handleAPILEDControl,    COST_ESSENTIAL) \
+    ROUTE(FACTORY_RESET,           HTTP_POST,            API_PREFIX API_FACTORY_RESET,  _handleAPIFactoryReset,  COST_ESSENTIAL) \
+    ROUTE(RESTART,                 HTTP_POST,            API_PREFIX API_RESTART,        _handleAPIRestart,       COST_ESSENTIAL) \
+    ROUTE(METRICS,                 HTTP_GET,             API_PREFIX API_METRICS,        _handleAPIMetrics,       COST_NORMAL) \
+    ROUTE(PROFILE,                 HTTP_GET,             API_PREFIX API_PROFILE,        _handleAPIProfile,       COST_NORMAL) \
+    ROUTE(PROBE_GENERATE_204,      HTTP_GET | HTTP_HEAD, "/generate_204",               _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_GEN_204,           HTTP_GET | HTTP_HEAD, "/gen_204",                    _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_APPLE,             HTTP_GET | HTTP_HEAD, "/hotspot-detect.html",        _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_APPLE_LEGACY,      HTTP_GET | HTTP_HEAD, "/library/test/success.html",  _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_WINDOWS,           HTTP_GET | HTTP_HEAD, "/connecttest.txt",            _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_WINDOWS_NCSI,      HTTP_GET | HTTP_HEAD, "/ncsi.txt",                   _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_WINDOWS_REDIRECT,  HTTP_GET | HTTP_HEAD, "/redirect",                   _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_FIREFOX,           HTTP_GET | HTTP_HEAD, "/success.txt",                _handleCaptiveProbe,     COST_ESSENTIAL) \
+    ROUTE(PROBE_FIREFOX_CANONICAL, HTTP_GET | HTTP_HEAD, "/canonical.html",             _handleCaptiveProbe,     COST_ESSENTIAL)
+
+#define ROUTE_ID(id, method, path, handler, cost) ROUTE_##id,
+enum RouteId {
+    API_ROUTES(ROUTE_ID)
+    ROUTE_COUNT
+};
+
+#define ROUTE_ENTRY(id, method, path, handler, cost) { method, path, &WebServerManager::handler, cost },
+const WebServerManager::Route WebServerManager::_routes[] = {
+    API_ROUTES(ROUTE_ENTRY)
+};
+
+// Metrics slots after the API routes
+enum {
+    METRICS_SLOT_ASSETS = ROUTE_COUNT,
+    METRICS_SLOT_UNMATCHED,
+    METRICS_SLOT_COUNT
+};
+
+// Captive portal probe answers, served from flash
+static const char PROBE_APPLE_SUCCESS[] PROGMEM = "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>";
+static const char PROBE_WINDOWS_SUCCESS[] PROGMEM = "Microsoft Connect Test";
+static const char PROBE_NCSI_SUCCESS[] PROGMEM = "Microsoft NCSI";
+static const char PROBE_FIREFOX_SUCCESS[] PROGMEM = "success\n";
+
+// FNV-1a; the constexpr form turns route paths into switch case labels
+static constexpr uint32_t routeHash(const char* path, uint32_t hash = 2166136261UL) {
+    return *path ? routeHash(path + 1, (hash ^ (uint8_t)*path) * 16777619UL) : hash;
+}
+
+static uint32_t routeHashN(const char* path, size_t length) {
+    uint32_t hash = 2166136261UL;
+    
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619UL;
+    }
+    
+    return hash;
+}
+
+// WebSocket topic names, indexed by WsTopic
+static const char* const TOPIC_NAMES[TOPIC_COUNT] = {
+    "sensors",
+    "device-stats",
+    "wifi",
+    "alerts"
+};
+
+static int _findTopic(const char* name) {
+    for (int topic = 0; topic < TOPIC_COUNT; topic++) {
+        if (strcmp(TOPIC_NAMES[topic], name) == 0) {
+            return topic;
+        }
+    }
+    
+    return -1;
+}
+
+// True if an Accept-Encoding list allows coding: named, or covered by "*",
+// with a nonzero q-value. A named entry takes precedence over "*".
+static bool _acceptsEncoding(const char* header, const char* coding) {
+    size_t codingLength = strlen(coding);
+    int wildcard = -1;
+    const char* p = header;
+    
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        
+        const char* name = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ') p++;
+        size_t nameLength = p - name;
+        
+        // Parameters up to the next entry; only q matters
+        bool allowed = true;
+        while (*p && *p != ',') {
+            if (*p++ != ';') {
+                continue;
+            }
+            
+            while (*p == ' ') p++;
+            
+            if ((*p == 'q' || *p == 'Q') && p[1] == '=') {
+                allowed = strtod(p + 2, nullptr) > 0;
+            }
+        }
+        
+        if (nameLength == codingLength && strncasecmp(name, coding, nameLength) == 0) {
+            return allowed;
+        }
+        
+        if (nameLength == 1 && *name == '*') {
+            wildcard = allowed;
+        }
+    }
+    
+    return wildcard == 1;
+}
+
+// State for replaying missed readings to a resumed event stream client
+struct EventReplay {
+    AsyncEventSourceClient* client;
+    SensorManager* sensors;
+    int replayed;
+};
+
+// ================================
+// ROUTE DISPATCHER
+// ================================
+
+class WebServerManager::RouteDispatcher : public AsyncWebHandler {
+public:
+    explicit RouteDispatcher(WebServerManager* owner) : _owner(owner) {}
+    
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (_owner->_findRoute(request->url()) < 0) {
+            return false;
+        }
+        
+        // Keep request headers (If-None-Match etc.) for the handlers
+        request->addInterestingHeader("ANY");
+        return true;
+    }
+    
+    void handleRequest(AsyncWebServerRequest* request) override {
+        _owner->_dispatch(request);
+    }
+    
+    // Non-trivial so POST form bodies are parsed into parameters
+    bool isRequestHandlerTrivial() override {
+        return false;
+    }
+
+private:
+    WebServerManager* _owner;
+};
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+WebServerManager::WebServerManager() :
+    _server(nullptr),
+    _webSocket(nullptr),
+    _events(nullptr),
+    _wifiManager(nullptr),
+    _sensorManager(nullptr),
+    _isRunning(false),
+    _startTime(0),
+    _requestCount(0),
+    _errorCount(0),
+    _probeCount(0),
+    _wsDroppedFrames(0),
+    _wsCoalescedFrames(0),
+    _wsEvictedClients(0),
+    _loadLevel(LoadLevel::NORMAL),
+    _loadLevelSince(0),
+    _shedBroadcasts(0),
+    _rejectedConnections(0),
+    _onDeviceNameChangeCallback(nullptr),
+    _onLEDControlCallback(nullptr),
+    _onFactoryResetCallback(nullptr),
+    _onRestartCallback(nullptr),
+    _onProfileResetCallback(nullptr),
+    _routeDispatcher(nullptr),
+    _currentRoute(-1),
+    _currentStatus(0),
+    _currentBytes(0),
+    _routeMetrics(new RouteMetrics[METRICS_SLOT_COUNT]())
+{
+    memset(_wsClients, 0, sizeof(_wsClients));
+    _wsChanges = nullptr;
+    memset(_latestFrames, 0, sizeof(_latestFrames));
+    _instance = this;
+}
+
+void WebServerManager::begin() {
+    DEBUG_I("Initializing Web Server Manager...");
+    
+    // Create server instance
+    _server = new AsyncWebServer(WEB_SERVER_PORT);
+    _webSocket = new AsyncWebSocket(WEBSOCKET_PATH);
+    _wsChanges = xQueueCreate(WS_CHANGE_QUEUE_LENGTH, sizeof(WsClientChange));
+    
+    // Setup routes and handlers
+    _setupRoutes();
+    _setupWebSocketHandlers();
+    _setupEventSource();
+    _setupCORSHeaders();
+    
+    // Start server
+    start();
+    
+    DEBUG_I("Web Server Manager initialized successfully");
+}
+
+void WebServerManager::end() {
+    DEBUG_I("Shutting down Web Server Manager...");
+    
+    stop();
+    
+    if (_webSocket) {
+        delete _webSocket;
+        _webSocket = nullptr;
+        memset(_latestFrames, 0, sizeof(_latestFrames)); // Freed with the WebSocket's buffers
+    }
+    
+    if (_server) {
+        delete _server;
+        _server = nullptr;
+        _routeDispatcher = nullptr; // Owned and deleted by the server
+        _events = nullptr;
+    }
+    
+    DEBUG_I("Web Server Manager shutdown complete");
+}
+
+// ================================
+// SERVER CONTROL
+// ================================
+
+void WebServerManager::start() {
+    if (_isRunning || !_server) {
+        return;
+    }
+    
+    DEBUG_I("Starting web server on port %d", WEB_SERVER_PORT);
+    
+    _server->begin();
+    _isRunning = true;
+    _startTime = millis();
+    
+    DEBUG_I("Web server started successfully");
+}
+
+void WebServerManager::stop() {
+    if (!_isRunning || !_server) {
+        return;
+    }
+    
+    DEBUG_I("Stopping web server");
+    
+    _server->end();
+    _isRunning = false;
+    
+    DEBUG_I("Web server stopped");
+}
+
+bool WebServerManager::isRunning() {
+    return _isRunning;
+}
+
+// ================================
+// MAIN LOOP HANDLER
+// ================================
+
+void WebServerManager::handleClient() {
+    // WebSocket cleanup
+    if (_webSocket) {
+        _applyClientChanges();
+        _webSocket->cleanupClients();
+        _flushPendingFrames();
+    }
+}
+
+// ================================
+// WEBSOCKET MANAGEMENT
+// ================================
+
+void WebServerManager::broadcastMessage(const String& message) {
+    if (!_webSocket || _webSocket->count() == 0) {
+        return;
+    }
+    
+    // Sent to every client regardless of subscriptions; one shared copy of the payload
+    AsyncWebSocketMessageBuffer* frame = _makeSharedFrame(message);
+    if (!frame) {
+        _wsDroppedFrames += _webSocket->count();
+        return;
+    }
+    
+    frame->lock();
+    
+    // Event frames are not superseded by later ones, so slow clients lose them
+    for (AsyncWebSocketClient* client : _webSocket->getClients()) {
+        if (client->status() != WS_CONNECTED) {
+            continue;
+        }
+        
+        if (client->queueLen() >= WS_CLIENT_QUEUE_LIMIT) {
+            _wsDroppedFrames++;
+            continue;
+        }
+        
+        client->text(frame);
+    }
+    
+    frame->unlock();
+    _webSocket->_cleanBuffers();
+    
+    DEBUG_V("Broadcast message to %d clients", _webSocket->count());
+}
+
+// Serialise once and fan out to subscribers, honouring each client's cadence
+void WebServerManager::publish(WsTopic topic, const String& message, uint32_t eventId) {
+    if (_topicPaused(topic)) {
+        return;
+    }
+    
+    // Event stream consumers get every topic as a named event
+    if (_events && _events->count() > 0) {
+        _events->send(message.c_str(), TOPIC_NAMES[topic], eventId);
+    }
+    
+    if (!_hasWebSocketSubscribers(topic)) {
+        return;
+    }
+    
+    AsyncWebSocketMessageBuffer* frame = _makeSharedFrame(message);
+    if (!frame) {
+        _wsDroppedFrames++;
+        return;
+    }
+    
+    bool latestWins = (topic <= TOPIC_WIFI);
+    uint8_t bit = TOPIC_BIT(topic);
+    unsigned long now = millis();
+    
+    frame->lock();
+    
+    // State topics keep their newest frame alive for deferred clients
+    if (latestWins) {
+        if (_latestFrames[topic]) {
+            _latestFrames[topic]->unlock();
+        }
+        _latestFrames[topic] = frame;
+    }
+    
+    for (WebSocketClientState& state : _wsClients) {
+        if (state.id == 0 || !(state.topics & bit)) {
+            continue;
+        }
+        
+        AsyncWebSocketClient* client = _webSocket->client(state.id);
+        if (!client || client->status() != WS_CONNECTED) {
+            continue;
+        }
+        
+        if (_sendTopicFrame(state, client, topic, frame, now)) {
+            continue;
+        }
+        
+        if (!latestWins) {
+            _wsDroppedFrames++;
+        } else if (state.pending & bit) {
+            _wsCoalescedFrames++;
+        } else {
+            state.pending |= bit;
+        }
+    }
+    
+    if (!latestWins) {
+        frame->unlock();
+    }
+    
+    _webSocket->_cleanBuffers();
+}
+
+bool WebServerManager::hasSubscribers(WsTopic topic) {
+    return _hasWebSocketSubscribers(topic) || (_events && _events->count() > 0);
+}
+
+bool WebServerManager::_hasWebSocketSubscribers(WsTopic topic) {
+    if (!_webSocket || _webSocket->count() == 0) {
+        return false;
+    }
+    
+    for (const WebSocketClientState& state : _wsClients) {
+        if (state.id != 0 && (state.topics & TOPIC_BIT(topic))) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void WebServerManager::broadcastSensorData() {
+    if (_sensorManager && hasSubscribers(TOPIC_SENSORS) && !_topicPaused(TOPIC_SENSORS)) {
+        // Reading timestamps double as event ids for Last-Event-ID resumption
+        SensorReading reading = _sensorManager->getCurrentReading();
+        publish(TOPIC_SENSORS, _sensorManager->getReadingJSON(reading), reading.timestamp);
+    }
+}
+
+void WebServerManager::broadcastDeviceStats() {
+    if (_sensorManager && hasSubscribers(TOPIC_DEVICE_STATS) && !_topicPaused(TOPIC_DEVICE_STATS)) {
+        publish(TOPIC_DEVICE_STATS, _sensorManager->getDeviceStatsJSON());
+    }
+}
+
+int WebServerManager::getWebSocketClientCount() {
+    return _webSocket ? _webSocket->count() : 0;
+}
+
+unsigned long WebServerManager::getDroppedFrameCount() {
+    return _wsDroppedFrames;
+}
+
+unsigned long WebServerManager::getCoalescedFrameCount() {
+    return _wsCoalescedFrames;
+}
+
+// Cumulative cycles spent in request handlers; wraps freely
+uint32_t WebServerManager::getHandlerCycles() {
+    uint64_t cycles = 0;
+    
+    for (int slot = 0; slot < METRICS_SLOT_COUNT; slot++) {
+        cycles += _routeMetrics[slot].latency.sumCycles;
+    }
+    
+    return (uint32_t)cycles;
+}
+
+// ================================
+// MANAGER REFERENCES
+// ================================
+
+void WebServerManager::setWiFiManager(WiFiManager* wifiManager) {
+    _wifiManager = wifiManager;
+}
+
+void WebServerManager::setSensorManager(SensorManager* sensorManager) {
+    _sensorManager = sensorManager;
+}
+
+// ================================
+// CALLBACK REGISTRATION
+// ================================
+
+void WebServerManager::onDeviceNameChange(DeviceNameCallback callback) {
+    _onDeviceNameChangeCallback = callback;
+}
+
+void WebServerManager::onLEDControl(LEDControlCallback callback) {
+    _onLEDControlCallback = callback;
+}
+
+void WebServerManager::onFactoryReset(DeviceActionCallback callback) {
+    _onFactoryResetCallback = callback;
+}
+
+void WebServerManager::onRestart(DeviceActionCallback callback) {
+    _onRestartCallback = callback;
+}
+
+void WebServerManager::onProfileReset(DeviceActionCallback callback) {
+    _onProfileResetCallback = callback;
+}
+
+// ================================
+// ROUTE SETUP
+// ================================
+
+void WebServerManager::_setupRoutes() {
+    if (!_server) return;
+    
+    DEBUG_I("Setting up web server routes...");
+    
+    // One catch-all handler resolves every API route and static asset
+    _routeDispatcher = new RouteDispatcher(this);
+    _server->addHandler(_routeDispatcher);
+    
+    // 404 handler
+    _server->onNotFound([this](AsyncWebServerRequest* request) {
+        _dispatch(request);
+    });
+    
+    DEBUG_I("Web server routes configured (%d API routes, %d assets)", ROUTE_COUNT, (int)WEB_ASSET_COUNT);
+}
+
+void WebServerManager::_setupWebSocketHandlers() {
+    if (!_webSocket || !_server) return;
+    
+    DEBUG_I("Setting up WebSocket handlers...");
+    
+    _webSocket->onEvent(_staticWebSocketEvent);
+    _server->addHandler(_webSocket);
+    
+    DEBUG_I("WebSocket handlers configured");
+}
+
+void WebServerManager::_setupEventSource() {
+    if (!_server) return;
+    
+    _events = new AsyncEventSource(API_PREFIX API_EVENTS);
+    _events->onConnect([](AsyncEventSourceClient* client) {
+        if (_instance) {
+            _instance->_onEventSourceConnect(client);
+        }
+    });
+    _server->addHandler(_events);
+    
+    DEBUG_I("Event stream available at %s", API_PREFIX API_EVENTS);
+}
+
+void WebServerManager::_setupCORSHeaders() {
+    if (!_server) return;
+    
+    // Add CORS headers to all responses
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    DefaultHeaders::Instance().addHeader("Access-Control-Max-Age", String(CORS_MAX_AGE));
+    
+    DEBUG_I("CORS headers configured");
+}
+
+// ================================
+// PAGE HANDLERS
+// ================================
+
+void WebServerManager::_handleRoot(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_D("Handling root request from: %s", request->client()->remoteIP().toString().c_str());
+    
+    // Show dashboard if connected to WiFi, otherwise the WiFi setup page
+    if (_wifiManager && _wifiManager->isConnected()) {
+        _sendAsset(request, *WEB_PAGE_DASHBOARD);
+    } else {
+        _sendAsset(request, *WEB_PAGE_SETUP);
+    }
+}
+
+void WebServerManager::_handleNotFound(AsyncWebServerRequest* request) {
+    // For captive portal, redirect to root
+    if (_wifiManager && _wifiManager->isAccessPointActive()) {
+        _probeCount++;
+        DEBUG_V("Captive redirect: %s", request->url().c_str());
+        _sendPortalRedirect(request);
+        return;
+    }
+    
+    _errorCount++;
+    DEBUG_W("404 Not Found: %s", request->url().c_str());
+    _sendErrorResponse(request, "Page not found", 404);
+}
+
+// OS connectivity checks. While the Access Point is up every probe is sent
+// to the portal; otherwise each OS gets the answer that means "online".
+void WebServerManager::_handleCaptiveProbe(AsyncWebServerRequest* request) {
+    _probeCount++;
+    
+    if (_wifiManager && _wifiManager->isAccessPointActive()) {
+        _sendPortalRedirect(request);
+        return;
+    }
+    
+    const char* body = nullptr;
+    const char* contentType = "text/plain";
+    
+    switch (_currentRoute) {
+        case ROUTE_PROBE_APPLE:
+        case ROUTE_PROBE_APPLE_LEGACY:
+            body = PROBE_APPLE_SUCCESS;
+            contentType = "text/html";
+            break;
+        case ROUTE_PROBE_WINDOWS:
+            body = PROBE_WINDOWS_SUCCESS;
+            break;
+        case ROUTE_PROBE_WINDOWS_NCSI:
+            body = PROBE_NCSI_SUCCESS;
+            break;
+        case ROUTE_PROBE_FIREFOX:
+        case ROUTE_PROBE_FIREFOX_CANONICAL:
+            body = PROBE_FIREFOX_SUCCESS;
+            break;
+        default:
+            // Android and everything else: 204 No Content
+            _send(request, request->beginResponse(204), 204, 0);
+            return;
+    }
+    
+    size_t length = strlen_P(body);
+    _send(request, request->beginResponse_P(200, contentType, (const uint8_t*)body, length), 200, length);
+}
+
+void WebServerManager::_sendPortalRedirect(AsyncWebServerRequest* request) {
+    AsyncWebServerResponse* response = request->beginResponse(302);
+    response->addHeader("Location", AP_PORTAL_URL);
+    response->addHeader("Cache-Control", "no-store");
+    _send(request, response, 302, 0);
+}
+
+// ================================
+// API HANDLERS
+// ================================
+
+void WebServerManager::_handleAPIScan(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_D("API: WiFi scan request");
+    
+    if (!_wifiManager) {
+        _sendErrorResponse(request, "WiFi manager not available");
+        return;
+    }
+    
+    // Refresh in the background if stale (or ?refresh=1); always answer from cache
+    _wifiManager->requestScan(request->hasParam("refresh"));
+    _sendJSONResponse(request, _wifiManager->getScannedNetworksJSON());
+}
+
+void WebServerManager::_handleAPIConnect(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_D("API: WiFi connect request");
+    
+    if (!_wifiManager) {
+        _sendErrorResponse(request, "WiFi manager not available");
+        return;
+    }
+    
+    // Get POST parameters
+    String ssid = "";
+    String password = "";
+    
+    if (request->hasParam("ssid", true)) {
+        ssid = request->getParam("ssid", true)->value();
+    }
+    
+    if (request->hasParam("password", true)) {
+        password = request->getParam("password", true)->value();
+    }
+    
+    if (ssid.length() == 0) {
+        _sendErrorResponse(request, "SSID is required");
+        return;
+    }
+    
+    // Queue the request for the WiFi job; progress is reported via
+    // /api/connect/status and WebSocket
+    uint32_t jobId = _wifiManager->beginConnect(ssid, password);
+    
+    if (jobId == 0) {
+        _sendErrorResponse(request, "Invalid SSID");
+        return;
+    }
+    
+    _sendJSONResponse(request, _wifiManager->getConnectJobJSON(), 202);
+}
+
+void WebServerManager::_handleAPIConnectStatus(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_V("API: WiFi connect status request");
+    
+    if (!_wifiManager) {
+        _sendErrorResponse(request, "WiFi manager not available");
+        return;
+    }
+    
+    ConnectJob job = _wifiManager->getConnectJob();
+    
+    // Only the latest job is tracked; older ids have been superseded
+    if (job.id == 0 || (request->hasParam("job") && 
+                        (uint32_t)request->getParam("job")->value().toInt() != job.id)) {
+        _sendErrorResponse(request, "Unknown connection job", 404);
+        return;
+    }
+    
+    _sendJSONResponse(request, _wifiManager->getConnectJobJSON());
+}
+
+void WebServerManager::_handleAPIStatus(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_V("API: Status request");
+    
+    uint32_t fields = _parseFields(request);
+    JsonBuffer buffer(1024, HEAP_TAG_WEB);
+    JsonWriter json(buffer);
+    
+    json.beginObject();
+    
+    if (fields & FIELD_SERVER) {
+        String serverStatus = getServerStatus();
+        json.key("server").rawValue(serverStatus.c_str(), serverStatus.length());
+    }
+    
+    if (_wifiManager && (fields & FIELD_GROUP_WIFI)) {
+        json.key("wifi");
+        _wifiManager->writeStatusJSON(json);
+    }
+    
+    if (_sensorManager && (fields & FIELD_GROUP_SENSORS)) {
+        String sensorData = _sensorManager->getSensorDataJSON(fields);
+        json.key("sensors").rawValue(sensorData.c_str(), sensorData.length());
+    }
+    
+    json.endObject();
+    
+    _sendJSONResponse(request, buffer.release());
+}
+
+void WebServerManager::_handleAPISensorData(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_V("API: Sensor data request");
+    
+    if (_sensorManager) {
+        String sensorData = _sensorManager->getSensorDataJSON(_parseFields(request));
+        _sendJSONResponse(request, sensorData);
+    } else {
+        _sendErrorResponse(request, "Sensor manager not available");
+    }
+}
+
+void WebServerManager::_handleAPISensorHistory(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_V("API: Sensor history request");
+    
+    if (!_sensorManager) {
+        _sendErrorResponse(request, "Sensor manager not available");
+        return;
+    }
+    
+    // ?format=compact streams the columnar encoding instead of one object per reading
+    if (request->hasParam("format") && request->getParam("format")->value() == "compact") {
+        AsyncResponseStream* response = request->beginResponseStream("application/json");
+        size_t length = _sensorManager->writeSensorHistoryCompact(*response, _parseFields(request));
+        _addCORSHeaders(response);
+        _send(request, response, 200, length);
+    } else {
+        _sendJSONResponse(request, _sensorManager->getSensorHistoryJSON());
+    }
+}
+
+void WebServerManager::_handleAPIDeviceStats(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_V("API: Device stats request");
+    
+    if (_sensorManager) {
+        String deviceStats = _sensorManager->getDeviceStatsJSON(_parseFields(request));
+        _sendJSONResponse(request, deviceStats);
+    } else {
+        _sendErrorResponse(request, "Sensor manager not available");
+    }
+}
+
+void WebServerManager::_handleAPIDeviceName(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_D("API: Device name change request");
+    
+    String newName = "";
+    
+    if (request->hasParam("name", true)) {
+        newName = request->getParam("name", true)->value();
+    }
+    
+    if (!_validateDeviceName(newName)) {
+        _sendErrorResponse(request, "Invalid device name. Must be 3-32 characters, alphanumeric with hyphens/underscores only");
+        return;
+    }
+    
+    // Call the callback to change device name
+    if (_onDeviceNameChangeCallback) {
+        _onDeviceNameChangeCallback(newName);
+        
+        String response = "{\"success\":true,\"message\":\"Device name changed to: " + newName + "\"}";
+        _sendJSONResponse(request, response);
+    } else {
+        _sendErrorResponse(request, "Device name change not supported");
+    }
+}
+
+void WebServerManager::_handleAPILEDControl(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_D("API: LED control request");
+    
+    if (!request->hasParam("state", true)) {
+        _sendErrorResponse(request, "LED state parameter required");
+        return;
+    }
+    
+    String stateParam = request->getParam("state", true)->value();
+    bool ledState = (stateParam == "true" || stateParam == "1" || stateParam == "on");
+    
+    if (_onLEDControlCallback) {
+        _onLEDControlCallback(ledState);
+        
+        String response = "{\"success\":true,\"message\":\"LED turned " + String(ledState ? "on" : "off") + "\"}";
+        _sendJSONResponse(request, response);
+    } else {
+        _sendErrorResponse(request, "LED control not supported");
+    }
+}
+
+void WebServerManager::_handleAPIFactoryReset(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_I("API: Factory reset request");
+    
+    String response = "{\"success\":true,\"message\":\"Factory reset initiated. Device will restart in 3 seconds.\"}";
+    _sendJSONResponse(request, response);
+    
+    // Delay and then call factory reset
+    if (_onFactoryResetCallback) {
+        _onFactoryResetCallback();
+    }
+}
+
+void WebServerManager::_handleAPIRestart(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    DEBUG_I("API: Restart request");
+    
+    String response = "{\"success\":true,\"message\":\"Device restarting...\"}";
+    _sendJSONResponse(request, response);
+    
+    if (_onRestartCallback) {
+        _onRestartCallback();
+    }
+}
+
+// Prometheus text exposition of request, loop, WebSocket and heap metrics
+void WebServerManager::_handleAPIMetrics(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+    PrometheusWriter metrics(*response);
+    char labels[64];
+    
+    auto routeLabel = [&](int slot) -> const char* {
+        if (slot == METRICS_SLOT_ASSETS) return "/assets";
+        if (slot == METRICS_SLOT_UNMATCHED) return "unmatched";
+        return _routes[slot].path;
+    };
+    
+    // HTTP requests
+    metrics.family("esp_http_requests_total", "counter", "HTTP responses by route and status class");
+    for (int slot = 0; slot < METRICS_SLOT_COUNT; slot++) {
+        for (uint8_t statusClass = 0; statusClass < 5; statusClass++) {
+            if (_routeMetrics[slot].statusClass[statusClass] == 0) {
+                continue;
+            }
+            snprintf(labels, sizeof(labels), "route=\"%s\",code=\"%uxx\"", routeLabel(slot), statusClass + 1);
+            metrics.sample("esp_http_requests_total", labels, (unsigned long)_routeMetrics[slot].statusClass[statusClass]);
+        }
+    }
+    
+    metrics.family("esp_http_response_bytes_total", "counter", "Response body bytes by route");
+    for (int slot = 0; slot < METRICS_SLOT_COUNT; slot++) {
+        if (_routeMetrics[slot].latency.count == 0) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "route=\"%s\"", routeLabel(slot));
+        metrics.sample("esp_http_response_bytes_total", labels, (unsigned long)_routeMetrics[slot].bytesSent);
+    }
+    
+    metrics.family("esp_http_handler_duration_seconds", "histogram", "Time spent in the request handler");
+    for (int slot = 0; slot < METRICS_SLOT_COUNT; slot++) {
+        if (_routeMetrics[slot].latency.count == 0) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "route=\"%s\"", routeLabel(slot));
+        metrics.histogram("esp_http_handler_duration_seconds", labels, _routeMetrics[slot].latency);
+    }
+    
+    // Admission control
+    metrics.family("esp_load_level", "gauge", "Admission control level (0 normal, 1 constrained, 2 critical)");
+    metrics.sample("esp_load_level", nullptr, (unsigned long)_loadLevel);
+    
+    metrics.family("esp_http_requests_shed_total", "counter", "Requests refused with 503 under memory pressure");
+    for (int slot = 0; slot < METRICS_SLOT_COUNT; slot++) {
+        if (_routeMetrics[slot].shed == 0) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "route=\"%s\"", routeLabel(slot));
+        metrics.sample("esp_http_requests_shed_total", labels, (unsigned long)_routeMetrics[slot].shed);
+    }
+    
+    metrics.family("esp_broadcasts_shed_total", "counter", "Topic broadcasts paused under memory pressure");
+    metrics.sample("esp_broadcasts_shed_total", nullptr, _shedBroadcasts);
+    metrics.family("esp_connections_rejected_total", "counter", "Live connections refused under memory pressure");
+    metrics.sample("esp_connections_rejected_total", nullptr, _rejectedConnections);
+    
+    // Main loop
+    #if FEATURE_PROFILER
+    metrics.family("esp_loop_stage_duration_seconds", "histogram", "Time spent in each main loop stage");
+    for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", LOOP_STAGE_NAMES[stage]);
+        metrics.histogram("esp_loop_stage_duration_seconds", labels, loopStageMetrics[stage]);
+    }
+    #endif
+    
+    // CPU
+    if (cpuMonitor.hasCoreUsage()) {
+        metrics.family("esp_cpu_usage_percent", "gauge", "Busy time per core over the last sample window");
+        for (uint8_t core = 0; core < cpuMonitor.getCoreCount(); core++) {
+            snprintf(labels, sizeof(labels), "core=\"%u\"", core);
+            metrics.sample("esp_cpu_usage_percent", labels, (double)cpuMonitor.getCoreUsage(core));
+        }
+    }
+    
+    metrics.family("esp_task_cpu_percent", "gauge", "Share of one core used by each task over the last sample window");
+    for (uint8_t i = 0; i < cpuMonitor.getTaskCount(); i++) {
+        const CpuTaskUsage& task = cpuMonitor.getTask(i);
+        snprintf(labels, sizeof(labels), "task=\"%s\"", task.name);
+        metrics.sample("esp_task_cpu_percent", labels, (double)task.share);
+    }
+    
+    // WebSocket and event stream
+    unsigned long queued = 0;
+    unsigned long queueMax = 0;
+    
+    if (_webSocket) {
+        for (AsyncWebSocketClient* client : _webSocket->getClients()) {
+            size_t depth = client->queueLen();
+            queued += depth;
+            queueMax = max(queueMax, (unsigned long)depth);
+        }
+    }
+    
+    metrics.family("esp_websocket_clients", "gauge", "Connected WebSocket clients");
+    metrics.sample("esp_websocket_clients", nullptr, (unsigned long)getWebSocketClientCount());
+    metrics.family("esp_websocket_queued_frames", "gauge", "Frames queued across all WebSocket clients");
+    metrics.sample("esp_websocket_queued_frames", nullptr, queued);
+    metrics.family("esp_websocket_queue_depth_max", "gauge", "Deepest WebSocket client queue");
+    metrics.sample("esp_websocket_queue_depth_max", nullptr, queueMax);
+    metrics.family("esp_websocket_frames_dropped_total", "counter", "Frames dropped for slow WebSocket clients");
+    metrics.sample("esp_websocket_frames_dropped_total", nullptr, _wsDroppedFrames);
+    metrics.family("esp_websocket_frames_coalesced_total", "counter", "State frames superseded before delivery");
+    metrics.sample("esp_websocket_frames_coalesced_total", nullptr, _wsCoalescedFrames);
+    metrics.family("esp_websocket_evictions_total", "counter", "WebSocket clients evicted at the client limit");
+    metrics.sample("esp_websocket_evictions_total", nullptr, _wsEvictedClients);
+    metrics.family("esp_event_stream_clients", "gauge", "Connected Server-Sent Events clients");
+    metrics.sample("esp_event_stream_clients", nullptr, (unsigned long)(_events ? _events->count() : 0));
+    
+    // Heap
+    metrics.family("esp_heap_free_bytes", "gauge", "Free heap");
+    metrics.sample("esp_heap_free_bytes", nullptr, (unsigned long)ESP.getFreeHeap());
+    metrics.family("esp_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    metrics.sample("esp_heap_min_free_bytes", nullptr, (unsigned long)ESP.getMinFreeHeap());
+    metrics.family("esp_heap_max_alloc_bytes", "gauge", "Largest allocatable heap block");
+    metrics.sample("esp_heap_max_alloc_bytes", nullptr, (unsigned long)ESP.getMaxAllocHeap());
+    metrics.family("esp_heap_fragmentation_percent", "gauge", "Free heap outside the largest block");
+    metrics.sample("esp_heap_fragmentation_percent", nullptr, (double)getHeapHealth().fragmentation);
+    
+    // Block pools
+    metrics.family("esp_pool_blocks", "gauge", "Blocks reserved per pool size class");
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        const BlockPool& pool = getBlockPool(i);
+        snprintf(labels, sizeof(labels), "size=\"%u\"", (unsigned)pool.getBlockSize());
+        metrics.sample("esp_pool_blocks", labels, (unsigned long)pool.getBlockCount());
+    }
+    
+    metrics.family("esp_pool_in_use_blocks", "gauge", "Blocks currently handed out per size class");
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        const BlockPool& pool = getBlockPool(i);
+        snprintf(labels, sizeof(labels), "size=\"%u\"", (unsigned)pool.getBlockSize());
+        metrics.sample("esp_pool_in_use_blocks", labels, (unsigned long)pool.getInUse());
+    }
+    
+    metrics.family("esp_pool_peak_in_use_blocks", "gauge", "Most blocks handed out at once per size class");
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        const BlockPool& pool = getBlockPool(i);
+        snprintf(labels, sizeof(labels), "size=\"%u\"", (unsigned)pool.getBlockSize());
+        metrics.sample("esp_pool_peak_in_use_blocks", labels, (unsigned long)pool.getPeakInUse());
+    }
+    
+    metrics.family("esp_pool_allocations_total", "counter", "Blocks handed out per size class");
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        const BlockPool& pool = getBlockPool(i);
+        snprintf(labels, sizeof(labels), "size=\"%u\"", (unsigned)pool.getBlockSize());
+        metrics.sample("esp_pool_allocations_total", labels, (unsigned long)pool.getAllocations());
+    }
+    
+    metrics.family("esp_pool_exhausted_total", "counter", "Requests that fell back to the heap with the pools empty");
+    for (uint8_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        const BlockPool& pool = getBlockPool(i);
+        snprintf(labels, sizeof(labels), "size=\"%u\"", (unsigned)pool.getBlockSize());
+        metrics.sample("esp_pool_exhausted_total", labels, (unsigned long)pool.getExhaustedCount());
+    }
+    
+    metrics.family("esp_pool_oversize_total", "counter", "Requests larger than the largest pool block");
+    metrics.sample("esp_pool_oversize_total", nullptr, (unsigned long)getPoolOversizeCount());
+    
+    #if FEATURE_ASYNC_LOG
+    // Debug log ring
+    LogStats logStats = getLogStats();
+    metrics.family("esp_log_lines_total", "counter", "Debug lines written to the serial port");
+    metrics.sample("esp_log_lines_total", nullptr, (unsigned long)logStats.lines);
+    metrics.family("esp_log_dropped_total", "counter", "Debug lines dropped with the log buffer full");
+    metrics.sample("esp_log_dropped_total", nullptr, (unsigned long)logStats.dropped);
+    metrics.family("esp_log_truncated_total", "counter", "Debug lines whose arguments did not fit one record");
+    metrics.sample("esp_log_truncated_total", nullptr, (unsigned long)logStats.truncated);
+    metrics.family("esp_log_buffer_peak_bytes", "gauge", "Most of the log buffer in use at once");
+    metrics.sample("esp_log_buffer_peak_bytes", nullptr, (unsigned long)logStats.peakBytes);
+    #endif
+    
+    // Allocations by subsystem
+    HeapTagStats tagStats[HEAP_TAG_COUNT];
+    for (uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++) {
+        tagStats[tag] = getHeapTagStats((HeapTag)tag);
+    }
+    
+    metrics.family("esp_heap_allocations_total", "counter", "Allocations by subsystem");
+    for (uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++) {
+        snprintf(labels, sizeof(labels), "tag=\"%s\"", HEAP_TAG_NAMES[tag]);
+        metrics.sample("esp_heap_allocations_total", labels, (unsigned long)tagStats[tag].allocations);
+    }
+    
+    metrics.family("esp_heap_allocated_bytes_total", "counter", "Bytes allocated by subsystem");
+    for (uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++) {
+        snprintf(labels, sizeof(labels), "tag=\"%s\"", HEAP_TAG_NAMES[tag]);
+        metrics.sample("esp_heap_allocated_bytes_total", labels, (unsigned long)tagStats[tag].bytesAllocated);
+    }
+    
+    metrics.family("esp_heap_in_use_bytes", "gauge", "Live bytes from tracked allocators by subsystem");
+    for (uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++) {
+        snprintf(labels, sizeof(labels), "tag=\"%s\"", HEAP_TAG_NAMES[tag]);
+        metrics.sample("esp_heap_in_use_bytes", labels, (unsigned long)tagStats[tag].bytesInUse);
+    }
+    
+    metrics.family("esp_heap_allocation_failures_total", "counter", "Failed allocations by subsystem");
+    for (uint8_t tag = 0; tag < HEAP_TAG_COUNT; tag++) {
+        snprintf(labels, sizeof(labels), "tag=\"%s\"", HEAP_TAG_NAMES[tag]);
+        metrics.sample("esp_heap_allocation_failures_total", labels, (unsigned long)tagStats[tag].failures);
+    }
+    
+    metrics.family("esp_uptime_seconds", "gauge", "Time since boot");
+    metrics.sample("esp_uptime_seconds", nullptr, millis() / 1000.0);
+    
+    _send(request, response, 200, metrics.bytesWritten());
+}
+
+// Per-stage loop timing; ?reset=1 starts a new window after reading
+void WebServerManager::_handleAPIProfile(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    JsonWriter json(*response);
+    writeLoopProfileJSON(json);
+    
+    // The loop task owns the histograms; ask it to clear them
+    if (request->hasParam("reset") && _onProfileResetCallback) {
+        _onProfileResetCallback();
+    }
+    
+    _addCORSHeaders(response);
+    _send(request, response, 200, json.bytesWritten());
+}
+
+// ================================
+// WEBSOCKET HANDLERS
+// ================================
+
+void WebServerManager::_staticWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, 
+                                             AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (_instance) {
+        _instance->_onWebSocketEvent(server, client, type, arg, data, len);
+    }
+}
+
+void WebServerManager::_onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, 
+                                         AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            DEBUG_I("WebSocket client #%u connected from %s", client->id(), client->remoteIP().toString().c_str());
+            
+            if (!_admitConnection(server->count())) {
+                client->close(WS_EVICT_CLOSE_CODE, "low memory");
+                break;
+            }
+            
+            {
+                WsClientChange change = { client->id(), WS_CHANGE_CONNECT };
+                _queueClientChange(change);
+            }
+            
+            // Send current data to the new client
+            if (_sensorManager) {
+                client->text(_sensorManager->getSensorDataJSON());
+            }
+            break;
+            
+        case WS_EVT_DISCONNECT:
+            DEBUG_I("WebSocket client #%u disconnected", client->id());
+            {
+                WsClientChange change = { client->id(), WS_CHANGE_DISCONNECT };
+                _queueClientChange(change);
+            }
+            break;
+            
+        case WS_EVT_DATA: {
+            AwsFrameInfo* info = (AwsFrameInfo*)arg;
+            WsClientChange change = { client->id(), WS_CHANGE_ACTIVITY };
+            _queueClientChange(change);
+            
+            // Only handle complete, single-frame text messages
+            if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+                _handleWebSocketMessage(client, data, len);
+            }
+            break;
+        }
+            
+        case WS_EVT_PONG:
+        case WS_EVT_ERROR:
+            break;
+    }
+}
+
+void WebServerManager::_handleWebSocketMessage(AsyncWebSocketClient* client, uint8_t* data, size_t len) {
+    PooledJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, (const char*)data, len);
+    
+    if (error) {
+        DEBUG_W("Invalid WebSocket message: %s", error.c_str());
+        return;
+    }
+    
+    String command = doc["command"] | "";
+    
+    if (command == "get_sensor_data" && _sensorManager) {
+        client->text(_sensorManager->getSensorDataJSON());
+    } else if (command == "get_device_stats" && _sensorManager) {
+        client->text(_sensorManager->getDeviceStatsJSON());
+    } else if (command == "get_status") {
+        client->text(getServerStatus());
+    } else if (command == "led" && _onLEDControlCallback) {
+        _onLEDControlCallback(doc["state"] | false);
+    } else if (command == "subscribe" || command == "unsubscribe") {
+        _handleSubscribe(client, doc["topics"], command == "subscribe");
+    } else {
+        DEBUG_D("Unknown WebSocket command: %s", command.c_str());
+    }
+}
+
+// ================================
+// ADMISSION CONTROL
+// ================================
+
+static LoadLevel _classifyHeap(size_t freeHeap, size_t largestBlock, size_t margin) {
+    if (freeHeap < HEAP_CRITICAL_FREE + margin || largestBlock < HEAP_CRITICAL_BLOCK + margin) {
+        return LoadLevel::CRITICAL;
+    }
+    
+    if (freeHeap < HEAP_CONSTRAINED_FREE + margin || largestBlock < HEAP_CONSTRAINED_BLOCK + margin) {
+        return LoadLevel::CONSTRAINED;
+    }
+    
+    return LoadLevel::NORMAL;
+}
+
+static const char* _loadLevelName(LoadLevel level) {
+    switch (level) {
+        case LoadLevel::CONSTRAINED: return "constrained";
+        case LoadLevel::CRITICAL: return "critical";
+        default: return "normal";
+    }
+}
+
+// Re-evaluate memory headroom before deciding what to serve
+void WebServerManager::updateLoadLevel() {
+    size_t freeHeap = ESP.getFreeHeap();
+    size_t largestBlock = ESP.getMaxAllocHeap();
+    LoadLevel level = _classifyHeap(freeHeap, largestBlock, 0);
+    
+    // Step down only with some headroom to spare, so the level does not flap
+    if (level < _loadLevel) {
+        level = _classifyHeap(freeHeap, largestBlock, HEAP_RECOVERY_MARGIN);
+    }
+    
+    if (level == _loadLevel) {
+        return;
+    }
+    
+    DEBUG_W("Load level %s -> %s (free %u, largest block %u)",
+            _loadLevelName(_loadLevel), _loadLevelName(level), freeHeap, largestBlock);
+    
+    _loadLevel = level;
+    _loadLevelSince = millis();
+    
+    String alert = "{\"type\":\"alert\",\"level\":\"" + String(level == LoadLevel::NORMAL ? "info" : "warning") +
+                   "\",\"message\":\"Load level " + _loadLevelName(level) + "\"}";
+    publish(TOPIC_ALERTS, alert);
+}
+
+bool WebServerManager::_admitRoute(RouteCost cost) {
+    switch (cost) {
+        case COST_EXPENSIVE: return _loadLevel == LoadLevel::NORMAL;
+        case COST_NORMAL: return _loadLevel != LoadLevel::CRITICAL;
+        default: return true;
+    }
+}
+
+// Statistics pause first; sensor frames pause only when critical
+bool WebServerManager::_topicPaused(WsTopic topic) {
+    bool paused = false;
+    
+    if (topic == TOPIC_DEVICE_STATS) {
+        paused = _loadLevel != LoadLevel::NORMAL;
+    } else if (topic == TOPIC_SENSORS) {
+        paused = _loadLevel == LoadLevel::CRITICAL;
+    }
+    
+    if (paused) {
+        _shedBroadcasts++;
+    }
+    
+    return paused;
+}
+
+// connected includes the client being admitted
+bool WebServerManager::_admitConnection(size_t connected) {
+    bool admitted = true;
+    
+    if (_loadLevel == LoadLevel::CRITICAL) {
+        admitted = false;
+    } else if (_loadLevel == LoadLevel::CONSTRAINED) {
+        admitted = connected <= CONSTRAINED_MAX_CLIENTS;
+    }
+    
+    if (!admitted) {
+        _rejectedConnections++;
+        DEBUG_D("Live connection refused at load level %s", _loadLevelName(_loadLevel));
+    }
+    
+    return admitted;
+}
+
+// Shed requests are not errors; clients are told when to come back
+void WebServerManager::_sendUnavailable(AsyncWebServerRequest* request) {
+    _requestCount++;
+    
+    static const char BUSY[] = "{\"success\":false,\"error\":\"Server busy, retry later\"}";
+    AsyncWebServerResponse* response = request->beginResponse(503, "application/json", BUSY);
+    response->addHeader("Retry-After", String(SHED_RETRY_AFTER_S));
+    _addCORSHeaders(response);
+    _send(request, response, 503, sizeof(BUSY) - 1);
+}
+
+LoadLevel WebServerManager::getLoadLevel() {
+    return _loadLevel;
+}
+
+unsigned long WebServerManager::getLoadLevelDuration() {
+    return millis() - _loadLevelSince;
+}
+
+// ================================
+// EVENT STREAM
+// ================================
+
+// Replay readings the client missed from the history buffer, or send the
+// current reading to a fresh client so it has data before the next tick
+void WebServerManager::_onEventSourceConnect(AsyncEventSourceClient* client) {
+    if (!_admitConnection(_events->count())) {
+        client->close();
+        return;
+    }
+    
+    if (!_sensorManager) {
+        return;
+    }
+    
+    uint32_t lastId = client->lastId();
+    
+    if (lastId == 0) {
+        SensorReading reading = _sensorManager->getCurrentReading();
+        client->send(_sensorManager->getReadingJSON(reading).c_str(), TOPIC_NAMES[TOPIC_SENSORS],
+                     reading.timestamp, SSE_RETRY_MS);
+        return;
+    }
+    
+    EventReplay replay = { client, _sensorManager, 0 };
+    
+    int replayed = _sensorManager->forEachReadingSince(lastId, [](const SensorReading& reading, void* context) {
+        EventReplay* replay = static_cast<EventReplay*>(context);
+        replay->client->send(replay->sensors->getReadingJSON(reading).c_str(), TOPIC_NAMES[TOPIC_SENSORS],
+                             reading.timestamp, replay->replayed == 0 ? SSE_RETRY_MS : 0);
+        replay->replayed++;
+    }, &replay);
+    
+    DEBUG_D("Event stream client resumed after %u, replayed %d readings", lastId, replayed);
+}
+
+// ================================
+// WEBSOCKET CLIENT TRACKING
+// ================================
+
+WebSocketClientState* WebServerManager::_findClientState(uint32_t id) {
+    for (WebSocketClientState& state : _wsClients) {
+        if (state.id == id) {
+            return &state;
+        }
+    }
+    
+    return nullptr;
+}
+
+// Called from AsyncTCP callbacks
+void WebServerManager::_queueClientChange(WsClientChange& change) {
+    if (!_wsChanges || xQueueSend(_wsChanges, &change, 0) != pdTRUE) {
+        DEBUG_W("WebSocket change queue full, client #%u change dropped", change.id);
+    }
+}
+
+void WebServerManager::_applyClientChanges() {
+    WsClientChange change;
+    
+    while (_wsChanges && xQueueReceive(_wsChanges, &change, 0) == pdTRUE) {
+        switch (change.type) {
+            case WS_CHANGE_CONNECT:
+                _registerClient(change.id);
+                break;
+                
+            case WS_CHANGE_DISCONNECT:
+                _releaseClient(change.id);
+                break;
+                
+            case WS_CHANGE_ACTIVITY: {
+                WebSocketClientState* state = _findClientState(change.id);
+                if (state) {
+                    state->lastActivity = millis();
+                }
+                break;
+            }
+                
+            case WS_CHANGE_SUBSCRIBE:
+            case WS_CHANGE_UNSUBSCRIBE:
+                _applySubscription(change);
+                break;
+        }
+    }
+}
+
+void WebServerManager::_registerClient(uint32_t id) {
+    // Already gone if the disconnect was queued right behind the connect
+    if (!_webSocket->client(id)) {
+        return;
+    }
+    
+    WebSocketClientState* state = _findClientState(0);
+    
+    if (!state) {
+        DEBUG_W("No WebSocket state slot for client #%u", id);
+        return;
+    }
+    
+    memset(state, 0, sizeof(*state));
+    state->id = id;
+    state->lastActivity = millis();
+    state->topics = WS_DEFAULT_TOPICS;
+    
+    // Make room by dropping the client that has been quiet the longest
+    if (_webSocket->count() > MAX_WEBSOCKET_CLIENTS) {
+        _evictIdleClient(id);
+    }
+}
+
+void WebServerManager::_releaseClient(uint32_t id) {
+    WebSocketClientState* state = _findClientState(id);
+    
+    if (state) {
+        memset(state, 0, sizeof(*state));
+    }
+}
+
+void WebServerManager::_evictIdleClient(uint32_t keepId) {
+    WebSocketClientState* oldest = nullptr;
+    unsigned long now = millis();
+    
+    for (WebSocketClientState& state : _wsClients) {
+        if (state.id == 0 || state.id == keepId) {
+            continue;
+        }
+        
+        if (!oldest || now - state.lastActivity > now - oldest->lastActivity) {
+            oldest = &state;
+        }
+    }
+    
+    if (!oldest) {
+        return;
+    }
+    
+    AsyncWebSocketClient* client = _webSocket->client(oldest->id);
+    
+    DEBUG_W("WebSocket client limit reached, evicting idle client #%u", oldest->id);
+    
+    _releaseClient(oldest->id);
+    _wsEvictedClients++;
+    
+    if (client) {
+        client->close(WS_EVICT_CLOSE_CODE, "client limit");
+    }
+}
+
+// Accepts a list of topic names, or an object mapping topic names to the
+// minimum interval in milliseconds between frames (0 = every update)
+void WebServerManager::_handleSubscribe(AsyncWebSocketClient* client, JsonVariant topics, bool subscribe) {
+    WsClientChange change = { client->id(), subscribe ? WS_CHANGE_SUBSCRIBE : WS_CHANGE_UNSUBSCRIBE };
+    
+    auto add = [&](const char* name, unsigned long interval) {
+        int topic = _findTopic(name);
+        if (topic < 0) {
+            DEBUG_D("Unknown WebSocket topic: %s", name);
+            return;
+        }
+        
+        change.topics |= TOPIC_BIT(topic);
+        change.interval[topic] = min(interval, (unsigned long)WS_MAX_TOPIC_INTERVAL_MS);
+    };
+    
+    if (topics.is<JsonObject>()) {
+        for (JsonPair entry : topics.as<JsonObject>()) {
+            add(entry.key().c_str(), entry.value() | 0UL);
+        }
+    } else if (topics.is<JsonArray>()) {
+        for (JsonVariant entry : topics.as<JsonArray>()) {
+            add(entry | "", 0);
+        }
+    }
+    
+    _queueClientChange(change);
+}
+
+void WebServerManager::_applySubscription(const WsClientChange& change) {
+    WebSocketClientState* state = _findClientState(change.id);
+    AsyncWebSocketClient* client = _webSocket->client(change.id);
+    
+    if (!state || !client) {
+        return;
+    }
+    
+    for (uint8_t topic = 0; topic < TOPIC_COUNT; topic++) {
+        uint8_t bit = TOPIC_BIT(topic);
+        
+        if (!(change.topics & bit)) {
+            continue;
+        }
+        
+        if (change.type == WS_CHANGE_UNSUBSCRIBE) {
+            state->topics &= ~bit;
+            state->pending &= ~bit;
+            continue;
+        }
+        
+        state->topics |= bit;
+        state->interval[topic] = change.interval[topic];
+        state->lastSent[topic] = 0;
+        
+        // New subscribers get the current state without waiting for the next tick
+        if (_latestFrames[topic]) {
+            state->pending |= bit;
+        }
+    }
+    
+    _sendSubscription(client, *state);
+}
+
+void WebServerManager::_sendSubscription(AsyncWebSocketClient* client, const WebSocketClientState& state) {
+    JsonBuffer buffer(128, HEAP_TAG_WEB);
+    JsonWriter json(buffer);
+    
+    json.beginObject();
+    json.field("type", "subscription");
+    json.beginObject("topics");
+    
+    for (uint8_t topic = 0; topic < TOPIC_COUNT; topic++) {
+        if (state.topics & TOPIC_BIT(topic)) {
+            json.field(TOPIC_NAMES[topic], (unsigned long)state.interval[topic]);
+        }
+    }
+    
+    json.endObject();
+    json.endObject();
+    
+    client->text(buffer.release());
+}
+
+// Send a frame unless the client asked for a slower cadence or is backed up
+bool WebServerManager::_sendTopicFrame(WebSocketClientState& state, AsyncWebSocketClient* client,
+                                       WsTopic topic, AsyncWebSocketMessageBuffer* frame, unsigned long now) {
+    if (state.lastSent[topic] && now - state.lastSent[topic] < state.interval[topic]) {
+        return false;
+    }
+    
+    if (client->queueLen() >= WS_CLIENT_QUEUE_LIMIT) {
+        return false;
+    }
+    
+    client->text(frame);
+    state.lastSent[topic] = now;
+    state.pending &= ~TOPIC_BIT(topic);
+    return true;
+}
+
+void WebServerManager::_flushPendingFrames() {
+    unsigned long now = millis();
+    
+    for (WebSocketClientState& state : _wsClients) {
+        if (state.id == 0) {
+            continue;
+        }
+        
+        AsyncWebSocketClient* client = _webSocket->client(state.id);
+        
+        // Gone without its disconnect change (queue was full)
+        if (!client) {
+            _releaseClient(state.id);
+            continue;
+        }
+        
+        if (!state.pending) {
+            continue;
+        }
+        
+        if (client->status() != WS_CONNECTED) {
+            state.pending = 0;
+            continue;
+        }
+        
+        for (uint8_t topic = 0; topic < TOPIC_COUNT; topic++) {
+            if (!(state.pending & TOPIC_BIT(topic))) {
+                continue;
+            }
+            
+            if (!_latestFrames[topic]) {
+                state.pending &= ~TOPIC_BIT(topic);
+                continue;
+            }
+            
+            _sendTopicFrame(state, client, (WsTopic)topic, _latestFrames[topic], now);
+        }
+    }
+}
+
+// Serialised payload in a reference-counted buffer; clients queue pointers to it
+AsyncWebSocketMessageBuffer* WebServerManager::_makeSharedFrame(const String& payload) {
+    AsyncWebSocketMessageBuffer* buffer = _webSocket->makeBuffer(payload.length());
+    
+    if (!buffer) {
+        DEBUG_W("WebSocket frame allocation failed (%u bytes)", payload.length());
+        return nullptr;
+    }
+    
+    memcpy(buffer->get(), payload.c_str(), payload.length());
+    return buffer;
+}
+
+// ================================
+// RESPONSE HELPERS
+// ================================
+
+void WebServerManager::_sendJSONResponse(AsyncWebServerRequest* request, const String& json, int code) {
+    AsyncWebServerResponse* response = request->beginResponse(code, "application/json", json);
+    _addCORSHeaders(response);
+    _send(request, response, code, json.length());
+}
+
+void WebServerManager::_sendErrorResponse(AsyncWebServerRequest* request, const String& message, int code) {
+    _errorCount++;
+    
+    DEBUG_W("API error (%d): %s", code, message.c_str());
+    
+    JsonBuffer buffer(40 + message.length(), HEAP_TAG_WEB);
+    JsonWriter json(buffer);
+    json.beginObject();
+    json.field("success", false);
+    json.field("error", message);
+    json.endObject();
+    
+    _sendJSONResponse(request, buffer.release(), code);
+}
+
+// Resolves a path to a route index (< ROUTE_COUNT) or an asset index
+// offset by ROUTE_COUNT; -1 if unknown. Duplicate hashes fail to compile.
+int WebServerManager::_findRoute(const String& url) {
+    int index;
+    
+    #define ROUTE_CASE(id, method, path, handler, cost) case routeHash(path): index = ROUTE_##id; break;
+    #define ASSET_CASE(assetIndex, path) case routeHash(path): index = ROUTE_COUNT + assetIndex; break;
+    
+    switch (routeHashN(url.c_str(), url.length())) {
+        API_ROUTES(ROUTE_CASE)
+        WEB_ASSET_ROUTES(ASSET_CASE)
+        default: return -1;
+    }
+    
+    #undef ROUTE_CASE
+    #undef ASSET_CASE
+    
+    // An unknown path can still share a hash with a route
+    const char* path = index < ROUTE_COUNT ? _routes[index].path : WEB_ASSETS[index - ROUTE_COUNT].url;
+    return strcmp(path, url.c_str()) == 0 ? index : -1;
+}
+
+// Times every request with the cycle counter and files it under its route
+void WebServerManager::_dispatch(AsyncWebServerRequest* request) {
+    uint32_t start = metricsTimestamp();
+    int index = _findRoute(request->url());
+    
+    _currentStatus = 0;
+    _currentBytes = 0;
+    
+    _invokeRoute(request, index);
+    
+    int slot = index < 0 ? METRICS_SLOT_UNMATCHED : min(index, (int)METRICS_SLOT_ASSETS);
+    RouteMetrics& metrics = _routeMetrics[slot];
+    
+    metrics.latency.record(metricsTimestamp() - start);
+    metrics.bytesSent += _currentBytes;
+    
+    if (_currentStatus >= 100 && _currentStatus < 600) {
+        metrics.statusClass[_currentStatus / 100 - 1]++;
+    }
+}
+
+void WebServerManager::_invokeRoute(AsyncWebServerRequest* request, int index) {
+    if (index < 0) {
+        _handleNotFound(request);
+        return;
+    }
+    
+    if (index >= ROUTE_COUNT) {
+        _requestCount++;
+        _sendAsset(request, WEB_ASSETS[index - ROUTE_COUNT]);
+        return;
+    }
+    
+    const Route& route = _routes[index];
+    _currentRoute = index;
+    
+    if (!(request->method() & route.method)) {
+        _requestCount++;
+        _sendErrorResponse(request, "Method not allowed", 405);
+        return;
+    }
+    
+    if (!_admitRoute(route.cost)) {
+        _routeMetrics[index].shed++;
+        _sendUnavailable(request);
+        return;
+    }
+    
+    (this->*route.handler)(request);
+}
+
+// Every response goes through here so the dispatcher can record it
+void WebServerManager::_send(AsyncWebServerRequest* request, AsyncWebServerResponse* response, int code, size_t length) {
+    _currentStatus = code;
+    _currentBytes += length;
+    request->send(response);
+}
+
+// Serves a precompressed asset straight from flash; nothing is copied to the heap
+void WebServerManager::_sendAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+    // Precompressed copy for gzip clients, the plain one for everyone else
+    bool gzip = request->hasHeader("Accept-Encoding") &&
+                _acceptsEncoding(request->getHeader("Accept-Encoding")->value().c_str(), "gzip");
+    const char* etag = gzip ? asset.etag : asset.rawEtag;
+    
+    // Hashed asset URLs never change content; pages must revalidate
+    const char* cacheControl = asset.immutable ? "public, max-age=31536000, immutable" : "no-cache";
+    
+    // ETags hash the bytes of each encoding, so a match means the client copy is current
+    if (request->hasHeader("If-None-Match") && 
+        request->getHeader("If-None-Match")->value() == etag) {
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Vary", "Accept-Encoding");
+        response->addHeader("Cache-Control", cacheControl);
+        _send(request, response, 304, 0);
+        return;
+    }
+    
+    const uint8_t* data = gzip ? asset.data : asset.rawData;
+    size_t length = gzip ? asset.length : asset.rawLength;
+    
+    AsyncWebServerResponse* response = request->beginResponse_P(200, asset.mimeType, data, length);
+    if (gzip) {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", etag);
+    response->addHeader("Vary", "Accept-Encoding");
+    response->addHeader("Cache-Control", cacheControl);
+    _send(request, response, 200, length);
+}
+
+void WebServerManager::_addCORSHeaders(AsyncWebServerResponse* response) {
+    // Default CORS headers are added globally; only disable caching here
+    response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+}
+
+uint32_t WebServerManager::_parseFields(AsyncWebServerRequest* request) {
+    if (!request->hasParam("fields")) {
+        return FIELD_ALL;
+    }
+    
+    return parseFieldMask(request->getParam("fields")->value());
+}
+
+bool WebServerManager::_validateDeviceName(const String& name) {
+    if (name.length() < DEVICE_NAME_MIN_LENGTH || name.length() > DEVICE_NAME_MAX_LENGTH) {
+        return false;
+    }
+    
+    for (unsigned int i = 0; i < name.length(); i++) {
+        if (strchr(DEVICE_NAME_ALLOWED_CHARS, name.charAt(i)) == nullptr) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// ================================
+// SERVER STATISTICS
+// ================================
+
+String WebServerManager::getServerStatus() {
+    PooledJsonDocument doc(512);
+    
+    doc["running"] = _isRunning;
+    doc["uptime"] = getUptime();
+    doc["requests"] = _requestCount;
+    doc["errors"] = _errorCount;
+    doc["captive_probes"] = _probeCount;
+    doc["websocket_clients"] = getWebSocketClientCount();
+    doc["websocket_dropped"] = _wsDroppedFrames;
+    doc["websocket_coalesced"] = _wsCoalescedFrames;
+    doc["websocket_evicted"] = _wsEvictedClients;
+    doc["event_clients"] = _events ? _events->count() : 0;
+    doc["load_level"] = _loadLevelName(_loadLevel);
+    doc["free_heap"] = ESP.getFreeHeap();
+    
+    String output;
+    output.reserve(measureJson(doc));
+    serializeJson(doc, output);
+    return output;
+}
+
+unsigned long WebServerManager::getRequestCount() {
+    return _requestCount;
+}
+
+unsigned long WebServerManager::getErrorCount() {
+    return _errorCount;
+}
+
+unsigned long WebServerManager::getUptime() {
+    return _isRunning ? millis() - _startTime : 0;
+}
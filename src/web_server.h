@@ -1,51 +1,272 @@
- #ifndef WEB_SERVER_H
-#define WEB_SERVER_H
-
-#include <Arduino.h>
-#include <ESPAsyncWebServer.h>
-#include <AsyncTCP.h>
-#include <ArduinoJson.h>
-#include "config.h"
-
-// Forward declarations
-class WiFiManager;
-class SensorManager;
-
-// ================================
-// WEB SERVER MANAGER CLASS
-// ================================
-
-class WebServerManager {
-public:
-    // Constructor
-    WebServerManager();
-    
-    // Initialization
-    void begin();
-    void end();
-    
-    // Main loop handler
-    void handleClient();
-    
-    // Server Control
-    void start();
-    void stop();
-    bool isRunning();
-    
-    // WebSocket Management
-    void broadcastMessage(const String& message);
-    void broadcastSensorData();
-    void broadcastDeviceStats();
-    int getWebSocketClientCount();
-    
-    // Manager References (set these after creating managers)
-    void setWiFiManager(WiFiManager* wifiManager);
-    void setSensorManager(SensorManager* sensorManager);
-    
-    // Device Control Callbacks
-    void onDeviceNameChange(std::function<void(const String&)> callback);
-    void onLEDControl(std::function<void(bool)> callback);
-    void onFactoryReset(std::function<void()> callback);
-    void onRestart(std::function<void()> callback);
-  
-
+ #ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <AsyncTCP.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "api_fields.h"
+#include "metrics.h"
+
+// Forward declarations
+class WiFiManager;
+class SensorManager;
+struct WebAsset;
+
+// Device control callbacks are plain function pointers
+typedef void (*DeviceNameCallback)(const String& name);
+typedef void (*LEDControlCallback)(bool state);
+typedef void (*DeviceActionCallback)();
+
+// ================================
+// ADMISSION CONTROL
+// ================================
+
+// Load level derived from free heap and the largest free block
+enum class LoadLevel : uint8_t {
+    NORMAL,
+    CONSTRAINED,
+    CRITICAL
+};
+
+// How readily a route is shed under memory pressure
+enum RouteCost : uint8_t {
+    COST_ESSENTIAL,                // Portal, setup and control: always served
+    COST_NORMAL,                   // Refused when critical
+    COST_EXPENSIVE                 // Large allocations or radio time: refused when constrained
+};
+
+// ================================
+// WEBSOCKET TOPICS
+// ================================
+
+// Clients subscribe to topics over /ws and may ask for a minimum interval
+// per topic. State topics (sensors, device-stats, wifi) are latest-value-wins;
+// event topics (alerts) are dropped when a client is rate limited.
+enum WsTopic : uint8_t {
+    TOPIC_SENSORS,
+    TOPIC_DEVICE_STATS,
+    TOPIC_WIFI,
+    TOPIC_ALERTS,
+    TOPIC_COUNT
+};
+
+#define TOPIC_BIT(topic)          (1U << (topic))
+#define WS_DEFAULT_TOPICS         (TOPIC_BIT(TOPIC_SENSORS) | TOPIC_BIT(TOPIC_WIFI) | TOPIC_BIT(TOPIC_ALERTS))
+
+// ================================
+// WEBSOCKET CLIENT STATE
+// ================================
+
+// Per-client bookkeeping for subscriptions and backpressure. Slots live in a
+// fixed array so AsyncTCP callbacks never reallocate under the loop task.
+struct WebSocketClientState {
+    uint32_t id;                   // 0 = free slot
+    unsigned long lastActivity;    // Connect time or last frame received
+    uint8_t topics;                // Subscribed topic bits
+    uint8_t pending;               // Topics whose latest frame is deferred
+    uint32_t interval[TOPIC_COUNT];     // Minimum ms between frames
+    unsigned long lastSent[TOPIC_COUNT];
+};
+
+// Client state only changes on the loop task; AsyncTCP callbacks queue
+// what happened and the next handleClient() applies it
+enum WsChangeType : uint8_t {
+    WS_CHANGE_CONNECT,
+    WS_CHANGE_DISCONNECT,
+    WS_CHANGE_ACTIVITY,
+    WS_CHANGE_SUBSCRIBE,
+    WS_CHANGE_UNSUBSCRIBE
+};
+
+struct WsClientChange {
+    uint32_t id;
+    WsChangeType type;
+    uint8_t topics;                // Topic bits named by a (un)subscribe
+    uint32_t interval[TOPIC_COUNT];
+};
+
+// ================================
+// WEB SERVER MANAGER CLASS
+// ================================
+
+class WebServerManager {
+public:
+    // Constructor
+    WebServerManager();
+    
+    // Initialization
+    void begin();
+    void end();
+    
+    // Main loop handlers (scheduled jobs)
+    void handleClient();
+    void updateLoadLevel();
+    
+    // Server Control
+    void start();
+    void stop();
+    bool isRunning();
+    
+    // WebSocket Management
+    void broadcastMessage(const String& message);
+    void publish(WsTopic topic, const String& message, uint32_t eventId = 0);
+    bool hasSubscribers(WsTopic topic);
+    void broadcastSensorData();
+    void broadcastDeviceStats();
+    int getWebSocketClientCount();
+    
+    // Manager References (set these after creating managers)
+    void setWiFiManager(WiFiManager* wifiManager);
+    void setSensorManager(SensorManager* sensorManager);
+    
+    // Device Control Callbacks
+    void onDeviceNameChange(DeviceNameCallback callback);
+    void onLEDControl(LEDControlCallback callback);
+    void onFactoryReset(DeviceActionCallback callback);
+    void onRestart(DeviceActionCallback callback);
+    void onProfileReset(DeviceActionCallback callback);
+    
+    // Server Statistics
+    String getServerStatus();
+    unsigned long getRequestCount();
+    unsigned long getErrorCount();
+    unsigned long getUptime();
+    unsigned long getDroppedFrameCount();
+    unsigned long getCoalescedFrameCount();
+    uint32_t getHandlerCycles();
+    
+    // Admission Control
+    LoadLevel getLoadLevel();
+    unsigned long getLoadLevelDuration();
+
+private:
+    // Server instances
+    AsyncWebServer* _server;
+    AsyncWebSocket* _webSocket;
+    AsyncEventSource* _events;     // Owned and deleted by the server
+    
+    // Manager references
+    WiFiManager* _wifiManager;
+    SensorManager* _sensorManager;
+    
+    // Server state
+    bool _isRunning;
+    unsigned long _startTime;
+    unsigned long _requestCount;
+    unsigned long _errorCount;
+    unsigned long _probeCount;     // Captive portal probes and redirects (not errors)
+    
+    // WebSocket fan-out
+    WebSocketClientState _wsClients[MAX_WEBSOCKET_CLIENTS + 1];    // Loop task only
+    QueueHandle_t _wsChanges;
+    AsyncWebSocketMessageBuffer* _latestFrames[TOPIC_COUNT];  // Shared, held locked until superseded
+    unsigned long _wsDroppedFrames;
+    unsigned long _wsCoalescedFrames;
+    unsigned long _wsEvictedClients;
+    
+    // Admission control
+    LoadLevel _loadLevel;
+    unsigned long _loadLevelSince;
+    unsigned long _shedBroadcasts;
+    unsigned long _rejectedConnections;
+    
+    // Callback functions
+    DeviceNameCallback _onDeviceNameChangeCallback;
+    LEDControlCallback _onLEDControlCallback;
+    DeviceActionCallback _onFactoryResetCallback;
+    DeviceActionCallback _onRestartCallback;
+    DeviceActionCallback _onProfileResetCallback;
+    
+    // Route dispatch
+    typedef void (WebServerManager::*RouteHandler)(AsyncWebServerRequest* request);
+    
+    struct Route {
+        WebRequestMethodComposite method;
+        const char* path;
+        RouteHandler handler;
+        RouteCost cost;
+    };
+    
+    class RouteDispatcher;
+    static const Route _routes[];
+    RouteDispatcher* _routeDispatcher;
+    int _currentRoute;             // Route being handled (AsyncTCP runs one at a time)
+    int _currentStatus;            // Status and body size of the response just sent
+    size_t _currentBytes;
+    RouteMetrics* _routeMetrics;   // Per route, plus assets and unmatched URLs
+    
+    int _findRoute(const String& url);
+    void _dispatch(AsyncWebServerRequest* request);
+    void _invokeRoute(AsyncWebServerRequest* request, int index);
+    
+    // Admission control
+    bool _admitRoute(RouteCost cost);
+    bool _topicPaused(WsTopic topic);
+    bool _admitConnection(size_t connected);
+    void _sendUnavailable(AsyncWebServerRequest* request);
+    
+    // Setup methods
+    void _setupRoutes();
+    void _setupWebSocketHandlers();
+    void _setupEventSource();
+    void _setupCORSHeaders();
+    
+    // Page handlers
+    void _handleRoot(AsyncWebServerRequest* request);
+    void _handleNotFound(AsyncWebServerRequest* request);
+    void _handleCaptiveProbe(AsyncWebServerRequest* request);
+    
+    // API handlers
+    void _handleAPIScan(AsyncWebServerRequest* request);
+    void _handleAPIConnect(AsyncWebServerRequest* request);
+    void _handleAPIConnectStatus(AsyncWebServerRequest* request);
+    void _handleAPIStatus(AsyncWebServerRequest* request);
+    void _handleAPISensorData(AsyncWebServerRequest* request);
+    void _handleAPISensorHistory(AsyncWebServerRequest* request);
+    void _handleAPIDeviceStats(AsyncWebServerRequest* request);
+    void _handleAPIDeviceName(AsyncWebServerRequest* request);
+    void _handleAPILEDControl(AsyncWebServerRequest* request);
+    void _handleAPIFactoryReset(AsyncWebServerRequest* request);
+    void _handleAPIRestart(AsyncWebServerRequest* request);
+    void _handleAPIMetrics(AsyncWebServerRequest* request);
+    void _handleAPIProfile(AsyncWebServerRequest* request);
+    
+    // WebSocket handlers
+    void _onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, 
+                           AwsEventType type, void* arg, uint8_t* data, size_t len);
+    void _handleWebSocketMessage(AsyncWebSocketClient* client, uint8_t* data, size_t len);
+    bool _hasWebSocketSubscribers(WsTopic topic);
+    void _onEventSourceConnect(AsyncEventSourceClient* client);
+    WebSocketClientState* _findClientState(uint32_t id);
+    void _queueClientChange(WsClientChange& change);
+    void _applyClientChanges();
+    void _registerClient(uint32_t id);
+    void _releaseClient(uint32_t id);
+    void _evictIdleClient(uint32_t keepId);
+    void _handleSubscribe(AsyncWebSocketClient* client, JsonVariant topics, bool subscribe);
+    void _applySubscription(const WsClientChange& change);
+    void _sendSubscription(AsyncWebSocketClient* client, const WebSocketClientState& state);
+    bool _sendTopicFrame(WebSocketClientState& state, AsyncWebSocketClient* client,
+                         WsTopic topic, AsyncWebSocketMessageBuffer* frame, unsigned long now);
+    void _flushPendingFrames();
+    AsyncWebSocketMessageBuffer* _makeSharedFrame(const String& payload);
+    
+    // Response helpers
+    void _send(AsyncWebServerRequest* request, AsyncWebServerResponse* response, int code, size_t length);
+    void _sendPortalRedirect(AsyncWebServerRequest* request);
+    void _sendAsset(AsyncWebServerRequest* request, const WebAsset& asset);
+    void _sendJSONResponse(AsyncWebServerRequest* request, const String& json, int code = 200);
+    void _sendErrorResponse(AsyncWebServerRequest* request, const String& message, int code = 400);
+    void _addCORSHeaders(AsyncWebServerResponse* response);
+    uint32_t _parseFields(AsyncWebServerRequest* request);
+    bool _validateDeviceName(const String& name);
+    
+    // Static WebSocket event handler
+    static void _staticWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, 
+                                      AwsEventType type, void* arg, uint8_t* data, size_t len);
+    static WebServerManager* _instance;
+};
+
+#endif // WEB_SERVER_H
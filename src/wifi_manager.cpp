@@ -1,593 +1,972 @@
- #include "wifi_manager.h"
-
-// Static instance pointer for event handling
-WiFiManager* WiFiManager::_instance = nullptr;
-
-// ================================
-// CONSTRUCTOR & INITIALIZATION
-// ================================
-
-WiFiManager::WiFiManager() :
-    _deviceName(DEFAULT_DEVICE_NAME),
-    _apSSID(""),
-    _connectedSSID(""),
-    _connectedPassword(""),
-    _isConnected(false),
-    _isAPActive(false),
-    _shouldReconnect(false),
-    _lastConnectionAttempt(0),
-    _lastReconnectAttempt(0),
-    _connectionStartTime(0),
-    _reconnectAttempts(0),
-    _dnsServer(nullptr),
-    _onConnectedCallback(nullptr),
-    _onDisconnectedCallback(nullptr),
-    _onAccessPointStartedCallback(nullptr)
-{
-    _instance = this;
-}
-
-void WiFiManager::begin(const String& deviceName) {
-    DEBUG_I("Initializing WiFi Manager...");
-    
-    setDeviceName(deviceName);
-    
-    // Initialize preferences
-    _preferences.begin(PREFS_WIFI_NAMESPACE, false);
-    
-    // Load saved WiFi credentials
-    _loadWiFiCredentials();
-    
-    // Set WiFi mode
-    WiFi.mode(WIFI_AP_STA);
-    
-    // Setup WiFi event handler
-    WiFi.onEvent(_wifiEventHandler);
-    
-    // Try to connect to saved WiFi first
-    if (_connectedSSID.length() > 0) {
-        DEBUG_I("Attempting to connect to saved WiFi: %s", _connectedSSID.c_str());
-        if (!connectToWiFi(_connectedSSID, _connectedPassword)) {
-            DEBUG_W("Failed to connect to saved WiFi, starting Access Point");
-            startAccessPoint();
-        }
-    } else {
-        DEBUG_I("No saved WiFi credentials, starting Access Point");
-        startAccessPoint();
-    }
-    
-    DEBUG_I("WiFi Manager initialized successfully");
-}
-
-void WiFiManager::end() {
-    DEBUG_I("Shutting down WiFi Manager...");
-    
-    stopAccessPoint();
-    disconnectWiFi();
-    
-    if (_dnsServer) {
-        delete _dnsServer;
-        _dnsServer = nullptr;
-    }
-    
-    _preferences.end();
-    
-    DEBUG_I("WiFi Manager shutdown complete");
-}
-
-// ================================
-// MAIN LOOP HANDLER
-// ================================
-
-void WiFiManager::handleClient() {
-    // Handle DNS server for captive portal
-    if (_dnsServer && _isAPActive) {
-        _dnsServer->processNextRequest();
-    }
-    
-    // Handle WiFi events and reconnection
-    _handleWiFiEvents();
-    
-    // Attempt reconnection if needed
-    if (_shouldReconnect && !_isConnected) {
-        _attemptReconnection();
-    }
-    
-    // Update connection status
-    _updateConnectionStatus();
-}
-
-// ================================
-// WIFI CONNECTION MANAGEMENT
-// ================================
-
-bool WiFiManager::connectToWiFi(const String& ssid, const String& password) {
-    if (!_isValidSSID(ssid)) {
-        DEBUG_E("Invalid SSID provided");
-        return false;
-    }
-    
-    DEBUG_I("Connecting to WiFi: %s", ssid.c_str());
-    
-    // Disconnect from current WiFi if connected
-    if (_isConnected) {
-        WiFi.disconnect();
-        delay(1000);
-    }
-    
-    // Store connection details
-    _connectedSSID = ssid;
-    _connectedPassword = password;
-    _connectionStartTime = millis();
-    _reconnectAttempts = 0;
-    
-    // Begin connection
-    if (password.length() > 0) {
-        WiFi.begin(ssid.c_str(), password.c_str());
-    } else {
-        WiFi.begin(ssid.c_str());
-    }
-    
-    // Wait for connection
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && 
-           (millis() - startTime) < WIFI_CONNECT_TIMEOUT_MS) {
-        delay(500);
-        DEBUG_D("Connecting...");
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        _isConnected = true;
-        _shouldReconnect = true;
-        
-        // Save credentials
-        _saveWiFiCredentials();
-        
-        // Stop Access Point if it was running
-        if (_isAPActive) {
-            stopAccessPoint();
-        }
-        
-        DEBUG_I("WiFi connected successfully!");
-        DEBUG_I("IP address: %s", WiFi.localIP().toString().c_str());
-        DEBUG_I("RSSI: %d dBm", WiFi.RSSI());
-        
-        // Call connected callback
-        if (_onConnectedCallback) {
-            _onConnectedCallback();
-        }
-        
-        return true;
-    } else {
-        DEBUG_E("WiFi connection failed. Status: %d", WiFi.status());
-        
-        // Start Access Point if connection failed
-        if (!_isAPActive) {
-            startAccessPoint();
-        }
-        
-        return false;
-    }
-}
-
-void WiFiManager::disconnectWiFi() {
-    if (_isConnected) {
-        DEBUG_I("Disconnecting from WiFi");
-        
-        _shouldReconnect = false;
-        WiFi.disconnect();
-        _isConnected = false;
-        
-        if (_onDisconnectedCallback) {
-            _onDisconnectedCallback();
-        }
-    }
-}
-
-bool WiFiManager::isConnected() {
-    return _isConnected && (WiFi.status() == WL_CONNECTED);
-}
-
-void WiFiManager::resetWiFiSettings() {
-    DEBUG_I("Resetting WiFi settings");
-    
-    // Disconnect current connection
-    disconnectWiFi();
-    
-    // Clear stored credentials
-    _clearWiFiCredentials();
-    
-    // Start Access Point
-    startAccessPoint();
-    
-    DEBUG_I("WiFi settings reset complete");
-}
-
-// ================================
-// ACCESS POINT MANAGEMENT
-// ================================
-
-void WiFiManager::startAccessPoint() {
-    if (_isAPActive) {
-        DEBUG_W("Access Point already active");
-        return;
-    }
-    
-    DEBUG_I("Starting Access Point: %s", _apSSID.c_str());
-    
-    // Configure Access Point
-    WiFi.softAPConfig(AP_IP_ADDRESS, AP_GATEWAY, AP_SUBNET);
-    
-    bool apStarted = WiFi.softAP(_apSSID.c_str(), AP_PASSWORD, AP_CHANNEL, 
-                                 AP_HIDDEN, AP_MAX_CONNECTIONS);
-    
-    if (apStarted) {
-        _isAPActive = true;
-        
-        // Setup captive portal
-        _setupCaptivePortal();
-        
-        DEBUG_I("Access Point started successfully");
-        DEBUG_I("SSID: %s", _apSSID.c_str());
-        DEBUG_I("Password: %s", AP_PASSWORD);
-        DEBUG_I("IP: %s", WiFi.softAPIP().toString().c_str());
-        
-        // Call Access Point started callback
-        if (_onAccessPointStartedCallback) {
-            _onAccessPointStartedCallback();
-        }
-    } else {
-        DEBUG_E("Failed to start Access Point");
-    }
-}
-
-void WiFiManager::stopAccessPoint() {
-    if (!_isAPActive) {
-        return;
-    }
-    
-    DEBUG_I("Stopping Access Point");
-    
-    _stopCaptivePortal();
-    WiFi.softAPdisconnect(true);
-    _isAPActive = false;
-    
-    DEBUG_I("Access Point stopped");
-}
-
-bool WiFiManager::isAccessPointActive() {
-    return _isAPActive;
-}
-
-// ================================
-// NETWORK INFORMATION
-// ================================
-
-String WiFiManager::getConnectedSSID() {
-    return _isConnected ? WiFi.SSID() : "";
-}
-
-IPAddress WiFiManager::getLocalIP() {
-    return _isConnected ? WiFi.localIP() : IPAddress(0, 0, 0, 0);
-}
-
-IPAddress WiFiManager::getAccessPointIP() {
-    return _isAPActive ? WiFi.softAPIP() : IPAddress(0, 0, 0, 0);
-}
-
-String WiFiManager::getMACAddress() {
-    return WiFi.macAddress();
-}
-
-int WiFiManager::getRSSI() {
-    return _isConnected ? WiFi.RSSI() : 0;
-}
-
-// ================================
-// NETWORK SCANNING
-// ================================
-
-int WiFiManager::scanNetworks() {
-    DEBUG_I("Scanning for WiFi networks...");
-    
-    int networkCount = WiFi.scanNetworks();
-    
-    if (networkCount == -1) {
-        DEBUG_E("WiFi scan failed");
-        return 0;
-    }
-    
-    DEBUG_I("Found %d networks", networkCount);
-    return networkCount;
-}
-
-String WiFiManager::getScannedNetworksJSON() {
-    String json = "{\"networks\":[";
-    
-    int networkCount = WiFi.scanComplete();
-    
-    if (networkCount > 0) {
-        for (int i = 0; i < networkCount; i++) {
-            if (i > 0) json += ",";
-            
-            json += "{";
-            json += "\"ssid\":\"" + WiFi.SSID(i) + "\",";
-            json += "\"rssi\":" + String(WiFi.RSSI(i)) + ",";
-            json += "\"encryption\":\"" + _encryptionTypeToString(WiFi.encryptionType(i)) + "\"";
-            json += "}";
-        }
-        
-        // Clear scan results
-        WiFi.scanDelete();
-    }
-    
-    json += "]}";
-    return json;
-}
-
-// ================================
-// STATUS INFORMATION
-// ================================
-
-String WiFiManager::getStatusJSON() {
-    String json = "{";
-    json += "\"connected\":" + String(_isConnected ? "true" : "false") + ",";
-    json += "\"access_point_active\":" + String(_isAPActive ? "true" : "false") + ",";
-    json += "\"ssid\":\"" + getConnectedSSID() + "\",";
-    json += "\"local_ip\":\"" + getLocalIP().toString() + "\",";
-    json += "\"access_point_ip\":\"" + getAccessPointIP().toString() + "\",";
-    json += "\"rssi\":" + String(getRSSI()) + ",";
-    json += "\"mac_address\":\"" + getMACAddress() + "\",";
-    json += "\"reconnect_attempts\":" + String(_reconnectAttempts);
-    json += "}";
-    
-    return json;
-}
-
-String WiFiManager::getNetworkInfoJSON() {
-    String json = "{";
-    
-    if (_isConnected) {
-        json += "\"status\":\"connected\",";
-        json += "\"ssid\":\"" + WiFi.SSID() + "\",";
-        json += "\"ip\":\"" + WiFi.localIP().toString() + "\",";
-        json += "\"gateway\":\"" + WiFi.gatewayIP().toString() + "\",";
-        json += "\"subnet\":\"" + WiFi.subnetMask().toString() + "\",";
-        json += "\"dns\":\"" + WiFi.dnsIP().toString() + "\",";
-        json += "\"rssi\":" + String(WiFi.RSSI()) + ",";
-        json += "\"channel\":" + String(WiFi.channel());
-    } else if (_isAPActive) {
-        json += "\"status\":\"access_point\",";
-        json += "\"ssid\":\"" + _apSSID + "\",";
-        json += "\"ip\":\"" + WiFi.softAPIP().toString() + "\",";
-        json += "\"clients\":" + String(WiFi.softAPgetStationNum());
-    } else {
-        json += "\"status\":\"disconnected\"";
-    }
-    
-    json += ",\"mac\":\"" + WiFi.macAddress() + "\"";
-    json += "}";
-    
-    return json;
-}
-
-// ================================
-// CONFIGURATION
-// ================================
-
-void WiFiManager::setDeviceName(const String& name) {
-    _deviceName = name;
-    _apSSID = AP_SSID_PREFIX + name;
-    
-    // Sanitize AP SSID
-    _apSSID = _sanitizeSSID(_apSSID);
-    
-    DEBUG_D("Device name set to: %s", _deviceName.c_str());
-    DEBUG_D("AP SSID set to: %s", _apSSID.c_str());
-}
-
-String WiFiManager::getDeviceName() {
-    return _deviceName;
-}
-
-String WiFiManager::getAccessPointSSID() {
-    return _apSSID;
-}
-
-// ================================
-// CALLBACK REGISTRATION
-// ================================
-
-void WiFiManager::onConnected(std::function<void()> callback) {
-    _onConnectedCallback = callback;
-}
-
-void WiFiManager::onDisconnected(std::function<void()> callback) {
-    _onDisconnectedCallback = callback;
-}
-
-void WiFiManager::onAccessPointStarted(std::function<void()> callback) {
-    _onAccessPointStartedCallback = callback;
-}
-
-// ================================
-// PRIVATE METHODS
-// ================================
-
-void WiFiManager::_loadWiFiCredentials() {
-    _connectedSSID = _preferences.getString(PREF_WIFI_SSID, "");
-    _connectedPassword = _preferences.getString(PREF_WIFI_PASSWORD, "");
-    
-    if (_connectedSSID.length() > 0) {
-        DEBUG_I("Loaded WiFi credentials for: %s", _connectedSSID.c_str());
-    } else {
-        DEBUG_I("No saved WiFi credentials found");
-    }
-}
-
-void WiFiManager::_saveWiFiCredentials() {
-    _preferences.putString(PREF_WIFI_SSID, _connectedSSID);
-    _preferences.putString(PREF_WIFI_PASSWORD, _connectedPassword);
-    
-    DEBUG_I("WiFi credentials saved");
-}
-
-void WiFiManager::_clearWiFiCredentials() {
-    _preferences.remove(PREF_WIFI_SSID);
-    _preferences.remove(PREF_WIFI_PASSWORD);
-    
-    _connectedSSID = "";
-    _connectedPassword = "";
-    
-    DEBUG_I("WiFi credentials cleared");
-}
-
-void WiFiManager::_handleWiFiEvents() {
-    // Check if we lost connection
-    if (_isConnected && WiFi.status() != WL_CONNECTED) {
-        DEBUG_W("WiFi connection lost");
-        _isConnected = false;
-        
-        if (_onDisconnectedCallback) {
-            _onDisconnectedCallback();
-        }
-        
-        // Start reconnection attempts
-        if (_shouldReconnect) {
-            _lastReconnectAttempt = millis();
-        }
-    }
-}
-
-void WiFiManager::_attemptReconnection() {
-    unsigned long currentTime = millis();
-    
-    if (currentTime - _lastReconnectAttempt >= WIFI_RECONNECT_INTERVAL) {
-        if (_reconnectAttempts < WIFI_MAX_RECONNECT_ATTEMPTS) {
-            DEBUG_I("Attempting WiFi reconnection (%d/%d)", 
-                   _reconnectAttempts + 1, WIFI_MAX_RECONNECT_ATTEMPTS);
-            
-            WiFi.disconnect();
-            delay(1000);
-            
-            if (_connectedPassword.length() > 0) {
-                WiFi.begin(_connectedSSID.c_str(), _connectedPassword.c_str());
-            } else {
-                WiFi.begin(_connectedSSID.c_str());
-            }
-            
-            _reconnectAttempts++;
-            _lastReconnectAttempt = currentTime;
-        } else {
-            DEBUG_W("Max reconnection attempts reached, starting Access Point");
-            _shouldReconnect = false;
-            _reconnectAttempts = 0;
-            
-            if (!_isAPActive) {
-                startAccessPoint();
-            }
-        }
-    }
-}
-
-bool WiFiManager::_isValidSSID(const String& ssid) {
-    return ssid.length() > 0 && ssid.length() <= 32;
-}
-
-bool WiFiManager::_isValidPassword(const String& password) {
-    return password.length() == 0 || (password.length() >= 8 && password.length() <= 63);
-}
-
-String WiFiManager::_sanitizeSSID(const String& ssid) {
-    String sanitized = ssid;
-    
-    // Remove invalid characters
-    sanitized.replace(" ", "-");
-    sanitized.replace("_", "-");
-    
-    // Limit length
-    if (sanitized.length() > 32) {
-        sanitized = sanitized.substring(0, 32);
-    }
-    
-    return sanitized;
-}
-
-void WiFiManager::_updateConnectionStatus() {
-    bool currentlyConnected = (WiFi.status() == WL_CONNECTED);
-    
-    if (currentlyConnected && !_isConnected) {
-        _isConnected = true;
-        _reconnectAttempts = 0;
-        
-        DEBUG_I("WiFi connection established");
-        
-        if (_onConnectedCallback) {
-            _onConnectedCallback();
-        }
-    }
-}
-
-void WiFiManager::_setupCaptivePortal() {
-    if (!_dnsServer) {
-        _dnsServer = new DNSServer();
-    }
-    
-    // Start DNS server for captive portal
-    _dnsServer->start(DNS_PORT, "*", AP_IP_ADDRESS);
-    
-    DEBUG_I("Captive portal DNS server started");
-}
-
-void WiFiManager::_stopCaptivePortal() {
-    if (_dnsServer) {
-        _dnsServer->stop();
-        DEBUG_I("Captive portal DNS server stopped");
-    }
-}
-
-String WiFiManager::_encryptionTypeToString(wifi_auth_mode_t encryptionType) {
-    switch (encryptionType) {
-        case WIFI_AUTH_OPEN: return "none";
-        case WIFI_AUTH_WEP: return "WEP";
-        case WIFI_AUTH_WPA_PSK: return "WPA";
-        case WIFI_AUTH_WPA2_PSK: return "WPA2";
-        case WIFI_AUTH_WPA_WPA2_PSK: return "WPA/WPA2";
-        case WIFI_AUTH_WPA2_ENTERPRISE: return "WPA2-Enterprise";
-        default: return "unknown";
-    }
-}
-
-// ================================
-// STATIC EVENT HANDLER
-// ================================
-
-void WiFiManager::_wifiEventHandler(WiFiEvent_t event) {
-    if (!_instance) return;
-    
-    switch (event) {
-        case SYSTEM_EVENT_STA_CONNECTED:
-            DEBUG_D("WiFi event: Station connected");
-            break;
-            
-        case SYSTEM_EVENT_STA_DISCONNECTED:
-            DEBUG_D("WiFi event: Station disconnected");
-            break;
-            
-        case SYSTEM_EVENT_STA_GOT_IP:
-            DEBUG_D("WiFi event: Got IP address");
-            break;
-            
-        case SYSTEM_EVENT_AP_START:
-            DEBUG_D("WiFi event: Access Point started");
-            break;
-            
-        case SYSTEM_EVENT_AP_STOP:
-            DEBUG_D("WiFi event: Access Point stopped");
-            break;
-            
-        default:
-            break;
-    }
-}
-
+ #include "wifi_manager.h"
+#include "json_writer.h"
+#include <algorithm>
+
+// Static instance pointer for event handling
+WiFiManager* WiFiManager::_instance = nullptr;
+
+// ================================
+// CONSTRUCTOR & INITIALIZATION
+// ================================
+
+WiFiManager::WiFiManager() :
+    _deviceName(DEFAULT_DEVICE_NAME),
+    _apSSID(""),
+    _connectedSSID(""),
+    _connectedPassword(""),
+    _isConnected(false),
+    _isAPActive(false),
+    _shouldReconnect(false),
+    _lastConnectionAttempt(0),
+    _lastReconnectAttempt(0),
+    _connectionStartTime(0),
+    _reconnectAttempts(0),
+    _reconnectBeginTime(0),
+    _onConnectedCallback(nullptr),
+    _onDisconnectedCallback(nullptr),
+    _onAccessPointStartedCallback(nullptr),
+    _onConnectProgressCallback(nullptr),
+    _onWorkPendingCallback(nullptr),
+    _stateLock(nullptr),
+    _nextConnectJobId(1),
+    _connectPending(false),
+    _pendingJobId(0),
+    _pendingTime(0),
+    _apStopTime(0),
+    _scanRequested(false),
+    _scanForced(false),
+    _scanInProgress(false),
+    _scanStartTime(0),
+    _scanCompletedTime(0),
+    _scanCacheTTL(WIFI_SCAN_CACHE_TTL_MS)
+{
+    _connectJob.id = 0;
+    _connectJob.state = ConnectState::IDLE;
+    _connectJob.ssid[0] = '\0';
+    _connectJob.startTime = 0;
+    _connectJob.endTime = 0;
+    _connectJob.failureReason = nullptr;
+    _activeSSID[0] = '\0';
+    _macAddress[0] = '\0';
+    
+    _instance = this;
+}
+
+void WiFiManager::begin(const String& deviceName) {
+    DEBUG_I("Initializing WiFi Manager...");
+    
+    setDeviceName(deviceName);
+    
+    _stateLock = xSemaphoreCreateMutex();
+    
+    // The station MAC is burned into eFuse; format it once
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(_macAddress, sizeof(_macAddress), "%02X:%02X:%02X:%02X:%02X:%02X",
+             (uint8_t)mac, (uint8_t)(mac >> 8), (uint8_t)(mac >> 16),
+             (uint8_t)(mac >> 24), (uint8_t)(mac >> 32), (uint8_t)(mac >> 40));
+    
+    // Initialize preferences
+    _preferences.begin(PREFS_WIFI_NAMESPACE, false);
+    
+    // Load saved WiFi credentials
+    _loadWiFiCredentials();
+    
+    // Set WiFi mode
+    WiFi.mode(WIFI_AP_STA);
+    
+    // Setup WiFi event handler
+    WiFi.onEvent(_wifiEventHandler);
+    
+    // Try to connect to saved WiFi first; the Access Point is started if it fails
+    if (_connectedSSID.length() > 0) {
+        DEBUG_I("Attempting to connect to saved WiFi: %s", _connectedSSID.c_str());
+        if (!beginConnect(_connectedSSID, _connectedPassword)) {
+            DEBUG_W("Failed to connect to saved WiFi, starting Access Point");
+            startAccessPoint();
+        }
+    } else {
+        DEBUG_I("No saved WiFi credentials, starting Access Point");
+        startAccessPoint();
+    }
+    
+    DEBUG_I("WiFi Manager initialized successfully");
+}
+
+void WiFiManager::end() {
+    DEBUG_I("Shutting down WiFi Manager...");
+    
+    stopAccessPoint();
+    disconnectWiFi();
+    
+    _preferences.end();
+    
+    DEBUG_I("WiFi Manager shutdown complete");
+}
+
+// ================================
+// MAIN LOOP HANDLER
+// ================================
+
+void WiFiManager::handleClient() {
+    // Start a connection requested from the web server, then advance it
+    _startRequestedConnect();
+    
+    if (_connectJob.state == ConnectState::CONNECTING) {
+        _updateConnectJob();
+    }
+    
+    // Collect background scan results, then start any requested scan
+    if (_scanInProgress) {
+        _updateScan();
+    }
+    
+    _startRequestedScan();
+    
+    // Shut down the Access Point once clients had time to see the result
+    if (_apStopTime && (long)(millis() - _apStopTime) >= 0) {
+        _apStopTime = 0;
+        
+        if (_isConnected && _isAPActive) {
+            stopAccessPoint();
+        }
+    }
+    
+    // Handle WiFi events and reconnection
+    _handleWiFiEvents();
+    
+    // Attempt reconnection if needed
+    if (_shouldReconnect && !_isConnected) {
+        _attemptReconnection();
+    }
+    
+    // Update connection status
+    _updateConnectionStatus();
+}
+
+// ================================
+// WIFI CONNECTION MANAGEMENT
+// ================================
+
+uint32_t WiFiManager::beginConnect(const String& ssid, const String& password) {
+    if (!_isValidSSID(ssid)) {
+        DEBUG_E("Invalid SSID provided");
+        return 0;
+    }
+    
+    // A new request supersedes any job still pending or in progress
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    uint32_t jobId = _nextConnectJobId++;
+    _connectPending = true;
+    _pendingJobId = jobId;
+    _pendingTime = millis();
+    _pendingSSID = ssid;
+    _pendingPassword = password;
+    xSemaphoreGive(_stateLock);
+    
+    _wake();
+    return jobId;
+}
+
+// Snapshot of the latest job; a request not yet started reads as connecting
+ConnectJob WiFiManager::getConnectJob() {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    
+    ConnectJob job = _connectJob;
+    
+    if (_connectPending) {
+        job.id = _pendingJobId;
+        job.state = ConnectState::CONNECTING;
+        strlcpy(job.ssid, _pendingSSID.c_str(), sizeof(job.ssid));
+        job.startTime = _pendingTime;
+        job.endTime = 0;
+        job.failureReason = nullptr;
+    }
+    
+    xSemaphoreGive(_stateLock);
+    return job;
+}
+
+String WiFiManager::getConnectJobJSON() {
+    JsonBuffer buffer(160, HEAP_TAG_WIFI);
+    JsonWriter json(buffer);
+    writeConnectJobJSON(json);
+    return buffer.release();
+}
+
+void WiFiManager::writeConnectJobJSON(JsonWriter& json) {
+    ConnectJob job = getConnectJob();
+    unsigned long endTime = job.endTime ? job.endTime : millis();
+    
+    json.beginObject();
+    json.field("job_id", job.id);
+    json.field("state", _connectStateToString(job.state));
+    json.field("ssid", job.ssid);
+    json.field("elapsed_ms", endTime - job.startTime);
+    
+    if (job.state == ConnectState::CONNECTED) {
+        json.field("ip", WiFi.localIP());
+    } else if (job.state == ConnectState::FAILED) {
+        json.field("reason", job.failureReason);
+    }
+    
+    json.endObject();
+}
+
+void WiFiManager::disconnectWiFi() {
+    if (_isConnected) {
+        DEBUG_I("Disconnecting from WiFi");
+        
+        _shouldReconnect = false;
+        _reconnectBeginTime = 0;
+        WiFi.disconnect();
+        _isConnected = false;
+        
+        if (_onDisconnectedCallback) {
+            _onDisconnectedCallback();
+        }
+    }
+}
+
+bool WiFiManager::isConnected() {
+    return _isConnected && (WiFi.status() == WL_CONNECTED);
+}
+
+void WiFiManager::resetWiFiSettings() {
+    DEBUG_I("Resetting WiFi settings");
+    
+    // Disconnect current connection
+    disconnectWiFi();
+    
+    // Clear stored credentials
+    _clearWiFiCredentials();
+    
+    // Start Access Point
+    startAccessPoint();
+    
+    DEBUG_I("WiFi settings reset complete");
+}
+
+// ================================
+// ACCESS POINT MANAGEMENT
+// ================================
+
+void WiFiManager::startAccessPoint() {
+    if (_isAPActive) {
+        DEBUG_W("Access Point already active");
+        return;
+    }
+    
+    DEBUG_I("Starting Access Point: %s", _apSSID.c_str());
+    
+    // Configure Access Point
+    WiFi.softAPConfig(AP_IP_ADDRESS, AP_GATEWAY, AP_SUBNET);
+    
+    bool apStarted = WiFi.softAP(_apSSID.c_str(), AP_PASSWORD, AP_CHANNEL, 
+                                 AP_HIDDEN, AP_MAX_CONNECTIONS);
+    
+    if (apStarted) {
+        _isAPActive = true;
+        
+        // Setup captive portal
+        _setupCaptivePortal();
+        
+        // Warm the scan cache before the first client opens the setup page
+        requestScan();
+        
+        DEBUG_I("Access Point started successfully");
+        DEBUG_I("SSID: %s", _apSSID.c_str());
+        DEBUG_I("Password: %s", AP_PASSWORD);
+        DEBUG_I("IP: %s", WiFi.softAPIP().toString().c_str());
+        
+        // Call Access Point started callback
+        if (_onAccessPointStartedCallback) {
+            _onAccessPointStartedCallback();
+        }
+    } else {
+        DEBUG_E("Failed to start Access Point");
+    }
+}
+
+void WiFiManager::stopAccessPoint() {
+    if (!_isAPActive) {
+        return;
+    }
+    
+    DEBUG_I("Stopping Access Point");
+    
+    _stopCaptivePortal();
+    WiFi.softAPdisconnect(true);
+    _isAPActive = false;
+    
+    DEBUG_I("Access Point stopped");
+}
+
+bool WiFiManager::isAccessPointActive() {
+    return _isAPActive;
+}
+
+// ================================
+// NETWORK INFORMATION
+// ================================
+
+const char* WiFiManager::getConnectedSSID() {
+    return _isConnected ? _activeSSID : "";
+}
+
+IPAddress WiFiManager::getLocalIP() {
+    return _isConnected ? WiFi.localIP() : IPAddress(0, 0, 0, 0);
+}
+
+IPAddress WiFiManager::getAccessPointIP() {
+    return _isAPActive ? WiFi.softAPIP() : IPAddress(0, 0, 0, 0);
+}
+
+const char* WiFiManager::getMACAddress() {
+    return _macAddress;
+}
+
+int WiFiManager::getRSSI() {
+    return _isConnected ? WiFi.RSSI() : 0;
+}
+
+// ================================
+// NETWORK SCANNING
+// ================================
+
+// Records the request and wakes the WiFi job, which starts the scan
+void WiFiManager::requestScan(bool force) {
+    if (!force && isScanCacheFresh()) {
+        return;
+    }
+    
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    _scanRequested = true;
+    _scanForced = _scanForced || force;
+    xSemaphoreGive(_stateLock);
+    
+    _wake();
+}
+
+bool WiFiManager::isScanInProgress() {
+    return _scanInProgress;
+}
+
+bool WiFiManager::isScanCacheFresh() {
+    return _scanCompletedTime != 0 && (millis() - _scanCompletedTime) < _scanCacheTTL;
+}
+
+void WiFiManager::setScanCacheTTL(unsigned long ttl) {
+    _scanCacheTTL = ttl;
+    DEBUG_I("Scan cache TTL set to %lu ms", _scanCacheTTL);
+}
+
+int WiFiManager::getScannedNetworkCount() {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    int count = _scanResults.size();
+    xSemaphoreGive(_stateLock);
+    
+    return count;
+}
+
+// Called from the web server task; the WiFi job swaps in new results
+// under the same lock
+String WiFiManager::getScannedNetworksJSON() {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    
+    // Up to 96 bytes of fields per entry plus the SSID; only escaping can outgrow it
+    size_t estimate = 64;
+    for (const ScanResult& network : _scanResults) {
+        estimate += 96 + strlen(network.ssid);
+    }
+    
+    JsonBuffer buffer(estimate, HEAP_TAG_WIFI);
+    JsonWriter json(buffer);
+    
+    json.beginObject();
+    json.beginArray("networks");
+    
+    for (const ScanResult& network : _scanResults) {
+        json.beginObject();
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X", 
+                 network.bssid[0], network.bssid[1], network.bssid[2], 
+                 network.bssid[3], network.bssid[4], network.bssid[5]);
+        
+        json.field("ssid", network.ssid);
+        json.field("bssid", bssid);
+        json.field("rssi", network.rssi);
+        json.field("channel", network.channel);
+        json.field("encryption", _encryptionTypeToString(network.encryption));
+        json.endObject();
+    }
+    
+    json.endArray();
+    json.field("scanning", _scanInProgress);
+    
+    if (_scanCompletedTime != 0) {
+        json.field("age_ms", millis() - _scanCompletedTime);
+    }
+    
+    json.endObject();
+    
+    xSemaphoreGive(_stateLock);
+    return buffer.release();
+}
+
+// ================================
+// STATUS INFORMATION
+// ================================
+
+String WiFiManager::getStatusJSON() {
+    JsonBuffer buffer(256, HEAP_TAG_WIFI);
+    JsonWriter json(buffer);
+    writeStatusJSON(json);
+    return buffer.release();
+}
+
+void WiFiManager::writeStatusJSON(JsonWriter& json) {
+    json.beginObject();
+    json.field("connected", _isConnected);
+    json.field("access_point_active", _isAPActive);
+    json.field("ssid", getConnectedSSID());
+    json.field("local_ip", getLocalIP());
+    json.field("access_point_ip", getAccessPointIP());
+    json.field("rssi", getRSSI());
+    json.field("mac_address", getMACAddress());
+    json.field("reconnect_attempts", _reconnectAttempts);
+    json.field("dns_queries", _captiveDNS.getQueryCount());
+    json.endObject();
+}
+
+String WiFiManager::getNetworkInfoJSON() {
+    JsonBuffer buffer(256, HEAP_TAG_WIFI);
+    JsonWriter json(buffer);
+    
+    json.beginObject();
+    
+    if (_isConnected) {
+        json.field("status", "connected");
+        json.field("ssid", WiFi.SSID());
+        json.field("ip", WiFi.localIP());
+        json.field("gateway", WiFi.gatewayIP());
+        json.field("subnet", WiFi.subnetMask());
+        json.field("dns", WiFi.dnsIP());
+        json.field("rssi", (long)WiFi.RSSI());
+        json.field("channel", (long)WiFi.channel());
+    } else if (_isAPActive) {
+        json.field("status", "access_point");
+        json.field("ssid", _apSSID);
+        json.field("ip", WiFi.softAPIP());
+        json.field("clients", (unsigned int)WiFi.softAPgetStationNum());
+    } else {
+        json.field("status", "disconnected");
+    }
+    
+    json.field("mac", getMACAddress());
+    json.endObject();
+    
+    return buffer.release();
+}
+
+uint32_t WiFiManager::getDNSBusyCycles() {
+    return _captiveDNS.getBusyCycles();
+}
+
+// ================================
+// CONFIGURATION
+// ================================
+
+void WiFiManager::setDeviceName(const String& name) {
+    _deviceName = name;
+    _apSSID = AP_SSID_PREFIX + name;
+    
+    // Sanitize AP SSID
+    _apSSID = _sanitizeSSID(_apSSID);
+    
+    DEBUG_D("Device name set to: %s", _deviceName.c_str());
+    DEBUG_D("AP SSID set to: %s", _apSSID.c_str());
+}
+
+String WiFiManager::getDeviceName() {
+    return _deviceName;
+}
+
+String WiFiManager::getAccessPointSSID() {
+    return _apSSID;
+}
+
+// ================================
+// CALLBACK REGISTRATION
+// ================================
+
+void WiFiManager::onConnected(WiFiEventCallback callback) {
+    _onConnectedCallback = callback;
+}
+
+void WiFiManager::onDisconnected(WiFiEventCallback callback) {
+    _onDisconnectedCallback = callback;
+}
+
+void WiFiManager::onAccessPointStarted(WiFiEventCallback callback) {
+    _onAccessPointStartedCallback = callback;
+}
+
+void WiFiManager::onConnectProgress(ConnectProgressCallback callback) {
+    _onConnectProgressCallback = callback;
+}
+
+void WiFiManager::onWorkPending(WiFiEventCallback callback) {
+    _onWorkPendingCallback = callback;
+}
+
+// ================================
+// PRIVATE METHODS
+// ================================
+
+void WiFiManager::_loadWiFiCredentials() {
+    _connectedSSID = _preferences.getString(PREF_WIFI_SSID, "");
+    _connectedPassword = _preferences.getString(PREF_WIFI_PASSWORD, "");
+    
+    if (_connectedSSID.length() > 0) {
+        DEBUG_I("Loaded WiFi credentials for: %s", _connectedSSID.c_str());
+    } else {
+        DEBUG_I("No saved WiFi credentials found");
+    }
+}
+
+void WiFiManager::_saveWiFiCredentials() {
+    _preferences.putString(PREF_WIFI_SSID, _connectedSSID);
+    _preferences.putString(PREF_WIFI_PASSWORD, _connectedPassword);
+    
+    DEBUG_I("WiFi credentials saved");
+}
+
+void WiFiManager::_clearWiFiCredentials() {
+    _preferences.remove(PREF_WIFI_SSID);
+    _preferences.remove(PREF_WIFI_PASSWORD);
+    
+    _connectedSSID = "";
+    _connectedPassword = "";
+    
+    DEBUG_I("WiFi credentials cleared");
+}
+
+void WiFiManager::_handleWiFiEvents() {
+    // Check if we lost connection
+    if (_isConnected && WiFi.status() != WL_CONNECTED) {
+        DEBUG_W("WiFi connection lost");
+        _isConnected = false;
+        
+        if (_onDisconnectedCallback) {
+            _onDisconnectedCallback();
+        }
+        
+        // Start reconnection attempts
+        if (_shouldReconnect) {
+            _lastReconnectAttempt = millis();
+        }
+    }
+}
+
+// Two steps across WiFi job runs: disconnect, then begin once the radio has
+// had WIFI_RECONNECT_SETTLE_MS to drop the old association
+void WiFiManager::_attemptReconnection() {
+    unsigned long currentTime = millis();
+    
+    if (_reconnectBeginTime) {
+        if ((long)(currentTime - _reconnectBeginTime) >= 0) {
+            _reconnectBeginTime = 0;
+            
+            if (_connectedPassword.length() > 0) {
+                WiFi.begin(_connectedSSID.c_str(), _connectedPassword.c_str());
+            } else {
+                WiFi.begin(_connectedSSID.c_str());
+            }
+        }
+        
+        return;
+    }
+    
+    if (currentTime - _lastReconnectAttempt >= WIFI_RECONNECT_INTERVAL) {
+        if (_reconnectAttempts < WIFI_MAX_RECONNECT_ATTEMPTS) {
+            DEBUG_I("Attempting WiFi reconnection (%d/%d)", 
+                   _reconnectAttempts + 1, WIFI_MAX_RECONNECT_ATTEMPTS);
+            
+            WiFi.disconnect();
+            _reconnectBeginTime = (currentTime + WIFI_RECONNECT_SETTLE_MS) | 1;
+            
+            _reconnectAttempts++;
+            _lastReconnectAttempt = currentTime;
+        } else {
+            DEBUG_W("Max reconnection attempts reached, starting Access Point");
+            _shouldReconnect = false;
+            _reconnectAttempts = 0;
+            
+            if (!_isAPActive) {
+                startAccessPoint();
+            }
+        }
+    }
+}
+
+bool WiFiManager::_isValidSSID(const String& ssid) {
+    return ssid.length() > 0 && ssid.length() <= 32;
+}
+
+bool WiFiManager::_isValidPassword(const String& password) {
+    return password.length() == 0 || (password.length() >= 8 && password.length() <= 63);
+}
+
+String WiFiManager::_sanitizeSSID(const String& ssid) {
+    String sanitized = ssid;
+    
+    // Remove invalid characters
+    sanitized.replace(" ", "-");
+    sanitized.replace("_", "-");
+    
+    // Limit length
+    if (sanitized.length() > 32) {
+        sanitized = sanitized.substring(0, 32);
+    }
+    
+    return sanitized;
+}
+
+void WiFiManager::_cacheActiveSSID() {
+    strlcpy(_activeSSID, WiFi.SSID().c_str(), sizeof(_activeSSID));
+}
+
+void WiFiManager::_startRequestedConnect() {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    
+    if (!_connectPending) {
+        xSemaphoreGive(_stateLock);
+        return;
+    }
+    
+    String ssid = _pendingSSID;
+    String password = _pendingPassword;
+    uint32_t jobId = _pendingJobId;
+    _connectPending = false;
+    _pendingPassword = "";
+    
+    xSemaphoreGive(_stateLock);
+    
+    _startConnect(ssid, password, jobId);
+}
+
+void WiFiManager::_startConnect(const String& ssid, const String& password, uint32_t jobId) {
+    DEBUG_I("Connecting to WiFi: %s", ssid.c_str());
+    
+    // Disconnect from current WiFi if connected
+    if (_isConnected) {
+        WiFi.disconnect();
+        _isConnected = false;
+    }
+    
+    // Store connection details
+    _connectedSSID = ssid;
+    _connectedPassword = password;
+    _connectionStartTime = millis();
+    _reconnectAttempts = 0;
+    _reconnectBeginTime = 0;
+    _shouldReconnect = false;
+    _apStopTime = 0;
+    
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    _connectJob.id = jobId;
+    _connectJob.state = ConnectState::CONNECTING;
+    strlcpy(_connectJob.ssid, ssid.c_str(), sizeof(_connectJob.ssid));
+    _connectJob.startTime = _connectionStartTime;
+    _connectJob.endTime = 0;
+    _connectJob.failureReason = nullptr;
+    xSemaphoreGive(_stateLock);
+    
+    // Begin connection; progress is tracked in _updateConnectJob()
+    if (password.length() > 0) {
+        WiFi.begin(ssid.c_str(), password.c_str());
+    } else {
+        WiFi.begin(ssid.c_str());
+    }
+    
+    _notifyConnectProgress();
+}
+
+void WiFiManager::_updateConnectJob() {
+    wl_status_t status = WiFi.status();
+    unsigned long currentTime = millis();
+    
+    if (status == WL_CONNECTED) {
+        _isConnected = true;
+        _cacheActiveSSID();
+        _shouldReconnect = true;
+        _finishConnectJob(ConnectState::CONNECTED, nullptr);
+        
+        // Save credentials
+        _saveWiFiCredentials();
+        
+        // Keep the Access Point up briefly so the setup page can show the result
+        if (_isAPActive) {
+            _apStopTime = currentTime + WIFI_AP_SHUTDOWN_DELAY_MS;
+        }
+        
+        DEBUG_I("WiFi connected successfully!");
+        DEBUG_I("IP address: %s", WiFi.localIP().toString().c_str());
+        DEBUG_I("RSSI: %d dBm", WiFi.RSSI());
+        
+        // Call connected callback
+        if (_onConnectedCallback) {
+            _onConnectedCallback();
+        }
+        return;
+    }
+    
+    const char* failureReason = nullptr;
+    
+    if (status == WL_NO_SSID_AVAIL) {
+        failureReason = "ssid_not_found";
+    } else if (status == WL_CONNECT_FAILED) {
+        failureReason = "connect_failed";
+    } else if (currentTime - _connectJob.startTime >= WIFI_CONNECT_TIMEOUT_MS) {
+        failureReason = "timeout";
+    }
+    
+    if (failureReason) {
+        DEBUG_E("WiFi connection failed (%s). Status: %d", failureReason, status);
+        
+        WiFi.disconnect();
+        _finishConnectJob(ConnectState::FAILED, failureReason);
+        
+        // Start Access Point if connection failed
+        if (!_isAPActive) {
+            startAccessPoint();
+        }
+    }
+}
+
+void WiFiManager::_finishConnectJob(ConnectState state, const char* failureReason) {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    _connectJob.state = state;
+    _connectJob.endTime = millis();
+    _connectJob.failureReason = failureReason;
+    xSemaphoreGive(_stateLock);
+    
+    _notifyConnectProgress();
+}
+
+void WiFiManager::_notifyConnectProgress() {
+    if (_onConnectProgressCallback) {
+        _onConnectProgressCallback(_connectJob);
+    }
+}
+
+const char* WiFiManager::_connectStateToString(ConnectState state) {
+    switch (state) {
+        case ConnectState::CONNECTING: return "connecting";
+        case ConnectState::CONNECTED: return "connected";
+        case ConnectState::FAILED: return "failed";
+        default: return "idle";
+    }
+}
+
+// Starts a pending scan request; concurrent requests share one scan
+void WiFiManager::_startRequestedScan() {
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    bool requested = _scanRequested;
+    bool force = _scanForced;
+    _scanRequested = false;
+    _scanForced = false;
+    xSemaphoreGive(_stateLock);
+    
+    if (!requested || _scanInProgress) {
+        return;
+    }
+    
+    if (!force && isScanCacheFresh()) {
+        return;
+    }
+    
+    // Scanning would disturb a connection attempt in progress
+    if (_connectJob.state == ConnectState::CONNECTING) {
+        return;
+    }
+    
+    DEBUG_I("Starting background WiFi scan...");
+    
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+        DEBUG_E("WiFi scan failed to start");
+        return;
+    }
+    
+    _scanInProgress = true;
+    _scanStartTime = millis();
+}
+
+void WiFiManager::_updateScan() {
+    int16_t networkCount = WiFi.scanComplete();
+    
+    if (networkCount == WIFI_SCAN_RUNNING) {
+        if (millis() - _scanStartTime >= WIFI_SCAN_TIMEOUT_MS) {
+            DEBUG_W("WiFi scan timed out");
+            WiFi.scanDelete();
+            _scanInProgress = false;
+        }
+        return;
+    }
+    
+    _scanInProgress = false;
+    
+    if (networkCount < 0) {
+        DEBUG_E("WiFi scan failed");
+        return;
+    }
+    
+    unsigned long scanTime = millis();
+    
+    // Merge into a copy so readers never see the vector reallocate; only
+    // this task writes the cache, so copying it needs no lock
+    ScanResultList merged(_scanResults);
+    
+    // One entry per SSID, keeping the strongest BSSID
+    for (int i = 0; i < networkCount; i++) {
+        String ssid = WiFi.SSID(i);
+        
+        // Hidden networks cannot be selected from the list
+        if (ssid.length() == 0) {
+            continue;
+        }
+        
+        ScanResult* entry = _findScanResult(merged, ssid.c_str());
+        int32_t rssi = WiFi.RSSI(i);
+        
+        if (!entry) {
+            merged.push_back(ScanResult());
+            entry = &merged.back();
+            strlcpy(entry->ssid, ssid.c_str(), sizeof(entry->ssid));
+        } else if (entry->lastSeen == scanTime && entry->rssi >= rssi) {
+            // Already have a stronger BSSID for this SSID from this scan
+            continue;
+        }
+        
+        entry->rssi = rssi;
+        entry->channel = WiFi.channel(i);
+        entry->encryption = WiFi.encryptionType(i);
+        memcpy(entry->bssid, WiFi.BSSID(i), sizeof(entry->bssid));
+        entry->lastSeen = scanTime;
+    }
+    
+    WiFi.scanDelete();
+    
+    // Age out networks that have not been seen for a while
+    merged.erase(std::remove_if(merged.begin(), merged.end(),
+        [scanTime](const ScanResult& entry) {
+            return scanTime - entry.lastSeen > WIFI_SCAN_ENTRY_MAX_AGE_MS;
+        }), merged.end());
+    
+    // Strongest first; stable so equal signals keep their previous order
+    std::stable_sort(merged.begin(), merged.end(),
+        [](const ScanResult& a, const ScanResult& b) {
+            return a.rssi > b.rssi;
+        });
+    
+    if (merged.size() > WIFI_SCAN_MAX_RESULTS) {
+        merged.resize(WIFI_SCAN_MAX_RESULTS);
+    }
+    
+    xSemaphoreTake(_stateLock, portMAX_DELAY);
+    _scanResults.swap(merged);
+    _scanCompletedTime = scanTime;
+    xSemaphoreGive(_stateLock);
+    
+    DEBUG_I("Found %d networks, %d unique in cache", networkCount, (int)_scanResults.size());
+}
+
+ScanResult* WiFiManager::_findScanResult(ScanResultList& results, const char* ssid) {
+    for (ScanResult& entry : results) {
+        if (strcmp(entry.ssid, ssid) == 0) {
+            return &entry;
+        }
+    }
+    
+    return nullptr;
+}
+
+void WiFiManager::_wake() {
+    if (_onWorkPendingCallback) {
+        _onWorkPendingCallback();
+    }
+}
+
+void WiFiManager::_updateConnectionStatus() {
+    bool currentlyConnected = (WiFi.status() == WL_CONNECTED);
+    
+    if (currentlyConnected && !_isConnected) {
+        _isConnected = true;
+        _cacheActiveSSID();
+        _reconnectAttempts = 0;
+        _reconnectBeginTime = 0;
+        
+        DEBUG_I("WiFi connection established");
+        
+        if (_onConnectedCallback) {
+            _onConnectedCallback();
+        }
+    }
+}
+
+void WiFiManager::_setupCaptivePortal() {
+    // Resolve every name to the portal; runs in its own task
+    if (!_captiveDNS.begin(AP_IP_ADDRESS, DNS_PORT)) {
+        DEBUG_E("Captive portal DNS responder failed to start");
+    }
+}
+
+void WiFiManager::_stopCaptivePortal() {
+    _captiveDNS.end();
+}
+
+const char* WiFiManager::_encryptionTypeToString(wifi_auth_mode_t encryptionType) {
+    switch (encryptionType) {
+        case WIFI_AUTH_OPEN: return "none";
+        case WIFI_AUTH_WEP: return "WEP";
+        case WIFI_AUTH_WPA_PSK: return "WPA";
+        case WIFI_AUTH_WPA2_PSK: return "WPA2";
+        case WIFI_AUTH_WPA_WPA2_PSK: return "WPA/WPA2";
+        case WIFI_AUTH_WPA2_ENTERPRISE: return "WPA2-Enterprise";
+        default: return "unknown";
+    }
+}
+
+// ================================
+// STATIC EVENT HANDLER
+// ================================
+
+void WiFiManager::_wifiEventHandler(WiFiEvent_t event) {
+    if (!_instance) return;
+    
+    switch (event) {
+        case SYSTEM_EVENT_STA_CONNECTED:
+            DEBUG_D("WiFi event: Station connected");
+            break;
+            
+        case SYSTEM_EVENT_STA_DISCONNECTED:
+            DEBUG_D("WiFi event: Station disconnected");
+            break;
+            
+        case SYSTEM_EVENT_STA_GOT_IP:
+            DEBUG_D("WiFi event: Got IP address");
+            break;
+            
+        case SYSTEM_EVENT_AP_START:
+            DEBUG_D("WiFi event: Access Point started");
+            break;
+            
+        case SYSTEM_EVENT_AP_STOP:
+            DEBUG_D("WiFi event: Access Point stopped");
+            break;
+            
+        default:
+            break;
+    }
+}
+
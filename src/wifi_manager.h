@@ -1,140 +1,241 @@
- #ifndef WIFI_MANAGER_H
-#define WIFI_MANAGER_H
-
-#include <Arduino.h>
-#include <WiFi.h>
-#include <DNSServer.h>
-#include <Preferences.h>
-#include "config.h"
-
-// ================================
-// WIFI MANAGER CLASS
-// ================================
-
-class WiFiManager {
-public:
-    // Constructor
-    WiFiManager();
-    
-    // Initialization
-    void begin(const String& deviceName);
-    void end();
-    
-    // Main loop handler
-    void handleClient();
-    
-    // WiFi Connection Management
-    bool connectToWiFi(const String& ssid, const String& password);
-    void disconnectWiFi();
-    bool isConnected();
-    void resetWiFiSettings();
-    
-    // Access Point Management
-    void startAccessPoint();
-    void stopAccessPoint();
-    bool isAccessPointActive();
-    
-    // Network Information
-    String getConnectedSSID();
-    IPAddress getLocalIP();
-    IPAddress getAccessPointIP();
-    String getMACAddress();
-    int getRSSI();
-    
-    // Network Scanning
-    int scanNetworks();
-    String getScannedNetworksJSON();
-    
-    // Status Information
-    String getStatusJSON();
-    String getNetworkInfoJSON();
-    
-    // Configuration
-    void setDeviceName(const String& name);
-    String getDeviceName();
-    String getAccessPointSSID();
-    
-    // Callbacks
-    void onConnected(std::function<void()> callback);
-    void onDisconnected(std::function<void()> callback);
-    void onAccessPointStarted(std::function<void()> callback);
-
-private:
-    // Private member variables
-    String _deviceName;
-    String _apSSID;
-    String _connectedSSID;
-    String _connectedPassword;
-    
-    // Network state
-    bool _isConnected;
-    bool _isAPActive;
-    bool _shouldReconnect;
-    
-    // Timing variables
-    unsigned long _lastConnectionAttempt;
-    unsigned long _lastReconnectAttempt;
-    unsigned long _connectionStartTime;
-    int _reconnectAttempts;
-    
-    // DNS Server for captive portal
-    DNSServer* _dnsServer;
-    
-    // Preferences for persistent storage
-    Preferences _preferences;
-    
-    // Callback functions
-    std::function<void()> _onConnectedCallback;
-    std::function<void()> _onDisconnectedCallback;
-    std::function<void()> _onAccessPointStartedCallback;
-    
-    // Private methods
-    void _loadWiFiCredentials();
-    void _saveWiFiCredentials();
-    void _clearWiFiCredentials();
-    void _handleWiFiEvents();
-    void _attemptReconnection();
-    bool _isValidSSID(const String& ssid);
-    bool _isValidPassword(const String& password);
-    String _sanitizeSSID(const String& ssid);
-    void _updateConnectionStatus();
-    void _setupCaptivePortal();
-    void _stopCaptivePortal();
-    String _encryptionTypeToString(wifi_auth_mode_t encryptionType);
-    
-    // Static event handlers
-    static void _wifiEventHandler(WiFiEvent_t event);
-    static WiFiManager* _instance;
-};
-
-// ================================
-// WIFI EVENT TYPES
-// ================================
-
-enum class WiFiManagerEvent {
-    CONNECTED,
-    DISCONNECTED,
-    CONNECTION_FAILED,
-    ACCESS_POINT_STARTED,
-    ACCESS_POINT_STOPPED,
-    SCAN_COMPLETED
-};
-
-// ================================
-// WIFI STATUS STRUCTURE
-// ================================
-
-struct WiFiStatus {
-    bool connected;
-    bool accessPointActive;
-    String ssid;
-    IPAddress localIP;
-    IPAddress accessPointIP;
-    int rssi;
-    String macAddress;
-    unsigned long uptime;
-    int reconnectAttempts;
-};
-
-#endif // WIFI_MANAGER_H
-
+ #ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <vector>
+#include "config.h"
+#include "captive_dns.h"
+#include "heap_telemetry.h"
+
+class JsonWriter;
+
+// ================================
+// CONNECTION JOB
+// ================================
+
+enum class ConnectState {
+    IDLE,
+    CONNECTING,
+    CONNECTED,
+    FAILED
+};
+
+// Progress of the most recent /api/connect request
+struct ConnectJob {
+    uint32_t id;
+    ConnectState state;
+    char ssid[WIFI_SSID_MAX_LENGTH + 1];
+    unsigned long startTime;
+    unsigned long endTime;
+    const char* failureReason;
+};
+
+// Event callbacks are plain function pointers: nothing to allocate or copy
+typedef void (*WiFiEventCallback)();
+typedef void (*ConnectProgressCallback)(const ConnectJob& job);
+
+// ================================
+// SCAN RESULT
+// ================================
+
+// One entry per SSID, merged across scans
+struct ScanResult {
+    char ssid[33];
+    uint8_t bssid[6];       // Strongest access point seen for this SSID
+    int32_t rssi;
+    uint8_t channel;
+    wifi_auth_mode_t encryption;
+    unsigned long lastSeen;
+};
+
+typedef std::vector<ScanResult, TaggedAllocator<ScanResult, HEAP_TAG_WIFI>> ScanResultList;
+
+// ================================
+// WIFI MANAGER CLASS
+// ================================
+
+class WiFiManager {
+public:
+    // Constructor
+    WiFiManager();
+    
+    // Initialization
+    void begin(const String& deviceName);
+    void end();
+    
+    // Main loop handler
+    void handleClient();
+    
+    // WiFi Connection Management (non-blocking; returns job id, 0 if rejected).
+    // Safe from any task: the request is queued and started by the WiFi job.
+    uint32_t beginConnect(const String& ssid, const String& password);
+    ConnectJob getConnectJob();
+    String getConnectJobJSON();
+    void writeConnectJobJSON(JsonWriter& json);
+    void disconnectWiFi();
+    bool isConnected();
+    void resetWiFiSettings();
+    
+    // Access Point Management
+    void startAccessPoint();
+    void stopAccessPoint();
+    bool isAccessPointActive();
+    
+    // Network Information
+    const char* getConnectedSSID();
+    IPAddress getLocalIP();
+    IPAddress getAccessPointIP();
+    const char* getMACAddress();
+    int getRSSI();
+    
+    // Network Scanning (asynchronous, results cached for the TTL). Requests
+    // may come from any task; the scan is started by the WiFi job.
+    void requestScan(bool force = false);
+    bool isScanInProgress();
+    bool isScanCacheFresh();
+    void setScanCacheTTL(unsigned long ttl);
+    int getScannedNetworkCount();
+    String getScannedNetworksJSON();
+    
+    // Status Information
+    String getStatusJSON();
+    void writeStatusJSON(JsonWriter& json);
+    String getNetworkInfoJSON();
+    uint32_t getDNSBusyCycles();
+    
+    // Configuration
+    void setDeviceName(const String& name);
+    String getDeviceName();
+    String getAccessPointSSID();
+    
+    // Callbacks
+    void onConnected(WiFiEventCallback callback);
+    void onDisconnected(WiFiEventCallback callback);
+    void onAccessPointStarted(WiFiEventCallback callback);
+    void onConnectProgress(ConnectProgressCallback callback);
+    void onWorkPending(WiFiEventCallback callback);     // Run handleClient() soon
+
+private:
+    // Private member variables
+    String _deviceName;
+    String _apSSID;
+    String _connectedSSID;
+    String _connectedPassword;
+    
+    // Cached so status snapshots do not allocate
+    char _activeSSID[WIFI_SSID_MAX_LENGTH + 1];
+    char _macAddress[MAC_ADDRESS_LENGTH];
+    
+    // Network state
+    bool _isConnected;
+    bool _isAPActive;
+    bool _shouldReconnect;
+    
+    // Timing variables
+    unsigned long _lastConnectionAttempt;
+    unsigned long _lastReconnectAttempt;
+    unsigned long _connectionStartTime;
+    int _reconnectAttempts;
+    unsigned long _reconnectBeginTime;  // Pending WiFi.begin() of a reconnect, 0 if none
+    
+    // DNS responder for captive portal
+    CaptiveDNS _captiveDNS;
+    
+    // Preferences for persistent storage
+    Preferences _preferences;
+    
+    // Callback functions
+    WiFiEventCallback _onConnectedCallback;
+    WiFiEventCallback _onDisconnectedCallback;
+    WiFiEventCallback _onAccessPointStartedCallback;
+    ConnectProgressCallback _onConnectProgressCallback;
+    WiFiEventCallback _onWorkPendingCallback;
+    
+    // Guards state shared with the web server task: the scan cache and
+    // requests waiting for the WiFi job
+    SemaphoreHandle_t _stateLock;
+    
+    // Connection job; written on the loop task under _stateLock
+    ConnectJob _connectJob;
+    uint32_t _nextConnectJobId;
+    
+    // Connect request waiting for the WiFi job
+    bool _connectPending;
+    uint32_t _pendingJobId;
+    unsigned long _pendingTime;
+    String _pendingSSID;
+    String _pendingPassword;
+    unsigned long _apStopTime;
+    
+    // Scan cache
+    ScanResultList _scanResults;
+    bool _scanRequested;
+    bool _scanForced;
+    bool _scanInProgress;
+    unsigned long _scanStartTime;
+    unsigned long _scanCompletedTime;
+    unsigned long _scanCacheTTL;
+    
+    // Private methods
+    void _loadWiFiCredentials();
+    void _saveWiFiCredentials();
+    void _clearWiFiCredentials();
+    void _handleWiFiEvents();
+    void _attemptReconnection();
+    bool _isValidSSID(const String& ssid);
+    bool _isValidPassword(const String& password);
+    String _sanitizeSSID(const String& ssid);
+    void _updateConnectionStatus();
+    void _cacheActiveSSID();
+    void _startRequestedConnect();
+    void _startConnect(const String& ssid, const String& password, uint32_t jobId);
+    void _updateConnectJob();
+    void _startRequestedScan();
+    void _updateScan();
+    ScanResult* _findScanResult(ScanResultList& results, const char* ssid);
+    void _wake();
+    void _finishConnectJob(ConnectState state, const char* failureReason);
+    void _notifyConnectProgress();
+    const char* _connectStateToString(ConnectState state);
+    void _setupCaptivePortal();
+    void _stopCaptivePortal();
+    const char* _encryptionTypeToString(wifi_auth_mode_t encryptionType);
+    
+    // Static event handlers
+    static void _wifiEventHandler(WiFiEvent_t event);
+    static WiFiManager* _instance;
+};
+
+// ================================
+// WIFI EVENT TYPES
+// ================================
+
+enum class WiFiManagerEvent {
+    CONNECTED,
+    DISCONNECTED,
+    CONNECTION_FAILED,
+    ACCESS_POINT_STARTED,
+    ACCESS_POINT_STOPPED,
+    SCAN_COMPLETED
+};
+
+// ================================
+// WIFI STATUS STRUCTURE
+// ================================
+
+struct WiFiStatus {
+    bool connected;
+    bool accessPointActive;
+    char ssid[WIFI_SSID_MAX_LENGTH + 1];
+    IPAddress localIP;
+    IPAddress accessPointIP;
+    int rssi;
+    char macAddress[MAC_ADDRESS_LENGTH];
+    unsigned long uptime;
+    int reconnectAttempts;
+};
+
+#endif // WIFI_MANAGER_H
+
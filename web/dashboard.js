@@ -0,0 +1,174 @@
+// Dashboard: live sensor data over WebSocket plus device controls
+(function () {
+    var $ = function (id) { return document.getElementById(id); };
+
+    var SENSOR_LABELS = {
+        temperature: ["Temperature", " °C"],
+        humidity: ["Humidity", " %"],
+        pressure: ["Pressure", " hPa"],
+        light_level: ["Light", " %"],
+        motion_detected: ["Motion", ""],
+        battery_level: ["Battery", " %"]
+    };
+
+    var DEVICE_LABELS = {
+        uptime: ["Uptime", " ms"],
+        free_heap: ["Free heap", " B"],
+        wifi_ssid: ["WiFi", ""],
+        wifi_rssi: ["RSSI", " dBm"],
+        local_ip: ["IP", ""],
+        websocket_clients: ["Clients", ""]
+    };
+
+    function render(target, labels, data) {
+        var list = $(target);
+        list.textContent = "";
+
+        Object.keys(labels).forEach(function (key) {
+            if (!(key in data)) {
+                return;
+            }
+            var term = document.createElement("dt");
+            var value = document.createElement("dd");
+            term.textContent = labels[key][0];
+            value.textContent = data[key] + labels[key][1];
+            list.appendChild(term);
+            list.appendChild(value);
+        });
+    }
+
+    // Columnar ?format=compact history: timestamps are "base" plus running
+    // "dt" deltas, each channel is an integer array divided by its "scale"
+    function decodeHistory(data) {
+        var history = { timestamps: [], channels: {} };
+        var time = data.base;
+
+        (data.dt || []).forEach(function (delta) {
+            time += delta;
+            history.timestamps.push(time);
+        });
+
+        Object.keys(data.scale).forEach(function (key) {
+            history.channels[key] = data[key].map(function (value) {
+                return value / data.scale[key];
+            });
+        });
+
+        return history;
+    }
+
+    function sparkline(values) {
+        var svg = document.createElementNS("http://www.w3.org/2000/svg", "svg");
+        var line = document.createElementNS("http://www.w3.org/2000/svg", "polyline");
+        var min = Math.min.apply(null, values);
+        var range = Math.max.apply(null, values) - min || 1;
+
+        svg.setAttribute("viewBox", "0 0 100 20");
+        svg.setAttribute("preserveAspectRatio", "none");
+        svg.setAttribute("class", "spark");
+        line.setAttribute("points", values.map(function (value, i) {
+            var x = values.length > 1 ? i * 100 / (values.length - 1) : 50;
+            return x.toFixed(1) + "," + (19 - (value - min) * 18 / range).toFixed(1);
+        }).join(" "));
+        svg.appendChild(line);
+        return svg;
+    }
+
+    function renderHistory(history) {
+        var list = $("history");
+        list.textContent = "";
+
+        Object.keys(SENSOR_LABELS).forEach(function (key) {
+            var values = history.channels[key];
+            if (!values || values.length === 0) {
+                return;
+            }
+            var term = document.createElement("dt");
+            var value = document.createElement("dd");
+            term.textContent = SENSOR_LABELS[key][0] + " (" + values.length + ")";
+            value.appendChild(sparkline(values));
+            list.appendChild(term);
+            list.appendChild(value);
+        });
+    }
+
+    function refreshHistory() {
+        fetch("/api/sensor-history?format=compact")
+            .then(function (r) { return r.json(); })
+            .then(function (data) { renderHistory(decodeHistory(data)); })
+            .catch(function () {});
+    }
+
+    function show(text) {
+        $("message").textContent = text;
+    }
+
+    function post(url, params) {
+        return fetch(url, { method: "POST", body: new URLSearchParams(params) })
+            .then(function (r) { return r.json(); })
+            .then(function (data) { show(data.success ? data.message : data.error); });
+    }
+
+    function refreshDevice() {
+        fetch("/api/stats")
+            .then(function (r) { return r.json(); })
+            .then(function (data) { render("device", DEVICE_LABELS, data); })
+            .catch(function () {});
+    }
+
+    function connect() {
+        var socket = new WebSocket("ws://" + location.host + "/ws");
+
+        socket.onopen = function () {
+            $("live").textContent = "live";
+            $("live").className = "badge on";
+            socket.send(JSON.stringify({
+                command: "subscribe",
+                topics: { sensors: 0, "device-stats": 10000, alerts: 0 }
+            }));
+        };
+
+        socket.onmessage = function (event) {
+            var data = JSON.parse(event.data);
+            if (data.type === "alert") {
+                show(data.message);
+            } else if ("temperature" in data || "battery_level" in data) {
+                render("sensors", SENSOR_LABELS, data);
+            } else if ("uptime" in data) {
+                render("device", DEVICE_LABELS, data);
+            }
+        };
+
+        socket.onclose = function (event) {
+            // 1013: evicted because the device is at its client limit; back off
+            var busy = event.code === 1013;
+            $("live").textContent = busy ? "busy" : "offline";
+            $("live").className = "badge";
+            setTimeout(connect, busy ? 30000 : 3000);
+        };
+    }
+
+    var ledOn = false;
+    $("led").onclick = function () {
+        ledOn = !ledOn;
+        post("/api/led", { state: ledOn ? "on" : "off" });
+    };
+
+    $("restart").onclick = function () {
+        if (confirm("Restart the device?")) {
+            post("/api/restart", {});
+        }
+    };
+
+    $("rename").onsubmit = function (event) {
+        event.preventDefault();
+        post("/api/device-name", { name: $("name").value }).then(function () {
+            $("device-name").textContent = $("name").value;
+        });
+    };
+
+    connect();
+    refreshDevice();
+    refreshHistory();
+    setInterval(refreshHistory, 60000);
+})();
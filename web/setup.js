@@ -0,0 +1,86 @@
+// WiFi setup page: network list and connect form
+(function () {
+    var $ = function (id) { return document.getElementById(id); };
+
+    function show(text) {
+        $("message").textContent = text;
+    }
+
+    function renderNetworks(networks) {
+        var list = $("networks");
+        list.textContent = "";
+
+        if (!networks.length) {
+            list.innerHTML = '<li class="muted">No networks found</li>';
+            return;
+        }
+
+        networks.forEach(function (net) {
+            var item = document.createElement("li");
+            var name = document.createElement("span");
+            var info = document.createElement("span");
+            name.textContent = net.ssid;
+            info.className = "muted";
+            info.textContent = net.rssi + " dBm" + (net.encryption === "none" ? "" : " \u{1F512}");
+            item.appendChild(name);
+            item.appendChild(info);
+            item.onclick = function () {
+                $("ssid").value = net.ssid;
+                $("password").focus();
+            };
+            list.appendChild(item);
+        });
+    }
+
+    // Results come from the device's scan cache; poll while a scan is running
+    function scan(refresh) {
+        fetch("/api/scan" + (refresh ? "?refresh=1" : ""))
+            .then(function (r) { return r.json(); })
+            .then(function (data) {
+                if (data.networks.length || !data.scanning) {
+                    renderNetworks(data.networks);
+                }
+                if (data.scanning) {
+                    setTimeout(scan, 2000);
+                }
+            })
+            .catch(function () { show("Scan failed"); });
+    }
+
+    $("scan").onclick = function () { scan(true); };
+
+    // The connect request returns 202 with a job id; poll until it settles
+    function pollJob(jobId) {
+        fetch("/api/connect/status?job=" + jobId)
+            .then(function (r) { return r.json(); })
+            .then(function (job) {
+                if (job.state === "connecting") {
+                    show("Connecting to " + job.ssid + "… (" + Math.round(job.elapsed_ms / 1000) + " s)");
+                    setTimeout(function () { pollJob(jobId); }, 1000);
+                } else if (job.state === "connected") {
+                    show("Connected to " + job.ssid + ". Device address: " + job.ip);
+                } else {
+                    show("Could not connect to " + job.ssid + " (" + (job.reason || job.error) + ")");
+                }
+            })
+            .catch(function () { setTimeout(function () { pollJob(jobId); }, 2000); });
+    }
+
+    $("connect").onsubmit = function (event) {
+        event.preventDefault();
+        show("Connecting…");
+
+        fetch("/api/connect", { method: "POST", body: new URLSearchParams(new FormData(event.target)) })
+            .then(function (r) { return r.json(); })
+            .then(function (data) {
+                if (data.job_id) {
+                    pollJob(data.job_id);
+                } else {
+                    show(data.error);
+                }
+            })
+            .catch(function () { show("Connection request failed"); });
+    };
+
+    scan(false);
+})();